@@ -0,0 +1,67 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <communication/MpiOptimizedCommunicator.h>
+#include <util/LatencyRecorder.h>
+#include <util/StringConcat.h>
+
+/**
+ * Measures how long the rank 0 takes to send a packet to every other rank: as a blocking MPI_Send per recipient, as the
+ * communicators did before their fan-out went non-blocking, and through MpiOptimizedCommunicator::sendOthers. All ranks
+ * meet in a barrier after every broadcast, which is not measured.
+ *
+ * Usage: mpirun -np RANKS 3PC-bench-fanout [PAYLOAD_BYTES] [BROADCASTS]
+ */
+
+namespace {
+    const int WARM_UP_BROADCASTS = 10;
+    /** Keeps the blocking sends apart from the packets of the communicator */
+    const int BLOCKING_TAG = 1000;
+
+    template <typename Broadcast, typename Receive>
+    std::string measure(MpiOptimizedCommunicator& communicator, int broadcasts, Broadcast broadcast, Receive receive) {
+        LatencyRecorder latencies;
+        for (int i = -WARM_UP_BROADCASTS; i < broadcasts; ++i) {
+            if (communicator.getProcessId() == 0) {
+                const auto start = std::chrono::steady_clock::now();
+                broadcast(i);
+                if (i >= 0) {
+                    latencies.record(std::chrono::steady_clock::now() - start);
+                }
+            } else {
+                receive();
+            }
+            MPI_Barrier(MPI_COMM_WORLD);
+        }
+        return latencies.summary();
+    }
+}
+
+int main(int argc, char** argv) {
+    const std::size_t payloadBytes = argc > 1 ? std::stoul(argv[1]) : 7;
+    const int broadcasts = argc > 2 ? std::stoi(argv[2]) : 1000;
+    MpiOptimizedCommunicator communicator(argc, argv);
+    const std::string payload(payloadBytes, 'x');
+    std::vector<char> receiveBuffer(payloadBytes + 1);
+
+    const std::string blocking = measure(communicator, broadcasts, [&](int) {
+        for (ProcessId recipient = 1; recipient < communicator.getNumberOfProcesses(); ++recipient) {
+            MPI_Send(payload.data(), static_cast<int>(payload.size()), MPI_CHAR, recipient, BLOCKING_TAG, MPI_COMM_WORLD);
+        }
+    }, [&] {
+        MPI_Recv(receiveBuffer.data(), static_cast<int>(receiveBuffer.size()), MPI_CHAR, 0, BLOCKING_TAG,
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    });
+    const std::string nonBlocking = measure(communicator, broadcasts, [&](int i) {
+        communicator.sendOthers(i, MessageType::CAN_COMMIT, payload);
+    }, [&] {
+        communicator.receive(communicator.getDefaultTag());
+    });
+
+    if (communicator.getProcessId() == 0) {
+        std::cout << util::concat("[Benchmark] ", communicator.getNumberOfProcesses(), " ranks, ", payloadBytes,
+                                  " B payload: blocking MPI_Send ", blocking, "; sendOthers ", nonBlocking) << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <time.h>
+#include <communication/InProcessCommunicator.h>
+#include <logging/Logger.h>
+#include <util/StringConcat.h>
+
+/**
+ * Measures the CPU time a call of Logger::log with a protocol state costs the logging thread, first in the synchronous and
+ * then in the asynchronous mode. The entries are logged in bursts which fit into a ring, with pauses for the background
+ * thread to write them, like the protocol logs a few entries per packet. The entries go to the standard output and
+ * the results to the standard error.
+ *
+ * Usage: 3PC-bench-logger [BURSTS] > /dev/null
+ */
+
+namespace {
+    const unsigned BURST_SIZE = LOGGER_RING_CAPACITY / 4;
+    const std::chrono::milliseconds PAUSE_BETWEEN_BURSTS(2);
+
+    /**
+     * CPU time of the calling thread, which leaves out the background thread even if it shares the core
+     */
+    long getThreadCpuNanoseconds() {
+        timespec time {};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+        return time.tv_sec * 1000000000L + time.tv_nsec;
+    }
+
+    double measure(unsigned bursts) {
+        long logging = 0;
+        TransactionId transactionId = 0;
+        for (unsigned burst = 0; burst < bursts; ++burst) {
+            const long start = getThreadCpuNanoseconds();
+            for (unsigned i = 0; i < BURST_SIZE; ++i) {
+                Logger::log(LogContext {W, transactionId++}, "Entered state W");
+            }
+            logging += getThreadCpuNanoseconds() - start;
+            std::this_thread::sleep_for(PAUSE_BETWEEN_BURSTS);
+        }
+        return static_cast<double>(logging) / (static_cast<double>(bursts) * BURST_SIZE);
+    }
+}
+
+int main(int argc, char** argv) {
+    const unsigned bursts = argc > 1 ? static_cast<unsigned>(std::stoul(argv[1])) : 1000;
+    auto communicator = InProcessCommunicator::createCluster(1).front();
+
+    Logger::init(communicator, LoggingMode::SYNCHRONOUS);
+    Logger::registerThread("Bench", communicator);
+    const double synchronous = measure(bursts);
+
+    Logger::init(communicator, LoggingMode::ASYNCHRONOUS);
+    const double asynchronous = measure(bursts);
+    Logger::shutdown();
+
+    std::cerr << util::concat("[Benchmark] Logger::log: ", synchronous, " ns per call synchronously, ", asynchronous,
+                              " ns per call asynchronously, in bursts of ", BURST_SIZE, " entries") << std::endl;
+    return 0;
+}
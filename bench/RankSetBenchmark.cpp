@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <communication/ICommunicator.h>
+#include <util/RankSet.h>
+#include <util/StringConcat.h>
+
+/**
+ * Compares RankSet with the std::unordered_set it replaced, per phase of a transaction: gathering the responses of
+ * every other rank in a random order until the set says that all of them responded, and iterating the recipients.
+ *
+ * Usage: 3PC-bench-rankset [PHASES]
+ */
+
+namespace {
+    volatile long sink = 0;
+
+    template <typename Function>
+    double microsecondsPerPhase(int phases, Function phase) {
+        for (int i = 0; i < phases / 10; ++i) {
+            phase();
+        }
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < phases; ++i) {
+            phase();
+        }
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / phases;
+    }
+
+    /**
+     * Reuses the set for every phase, as the coordinator reuses the responders of a transaction.
+     */
+    template <typename Set>
+    double gather(const std::vector<ProcessId>& responders, int phases) {
+        Set responded;
+        return microsecondsPerPhase(phases, [&] {
+            responded.clear();
+            for (ProcessId responder : responders) {
+                responded.insert(responder);
+                if (responded.size() == responders.size()) {
+                    sink = sink + 1;
+                }
+            }
+        });
+    }
+
+    template <typename Set>
+    double iterate(const std::vector<ProcessId>& recipients, int phases) {
+        const Set set(recipients.begin(), recipients.end());
+        return microsecondsPerPhase(phases, [&] {
+            long sum = 0;
+            for (ProcessId recipient : set) {
+                sum += recipient;
+            }
+            sink = sink + sum;
+        });
+    }
+}
+
+int main(int argc, char** argv) {
+    const int phases = argc > 1 ? std::stoi(argv[1]) : 1000;
+    for (ProcessId ranks : {1024, 10000}) {
+        std::vector<ProcessId> others(static_cast<std::size_t>(ranks - 1));
+        std::iota(others.begin(), others.end(), 1);
+        std::shuffle(others.begin(), others.end(), std::mt19937(42));
+        std::cout << util::concat("[Benchmark] ", ranks, " ranks: gather a quorum ",
+                                  gather<std::unordered_set<ProcessId>>(others, phases), " us with unordered_set, ",
+                                  gather<RankSet>(others, phases), " us with RankSet; iterate the recipients ",
+                                  iterate<std::unordered_set<ProcessId>>(others, phases), " us with unordered_set, ",
+                                  iterate<RankSet>(others, phases), " us with RankSet") << std::endl;
+    }
+    return 0;
+}
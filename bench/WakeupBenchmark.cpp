@@ -0,0 +1,96 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <sys/resource.h>
+#include <communication/MpiOptimizedCommunicator.h>
+#include <communication/SharedMemoryCommunicator.h>
+#include <util/LatencyRecorder.h>
+#include <util/StringConcat.h>
+
+/**
+ * Measures what a receiving process costs while it waits and how quickly it wakes up: the rank 1 first waits in
+ * a receive which times out after the idle period, then receives packets the rank 0 sends after pauses long enough
+ * for a backoff to reach its longest sleep, each carrying the steady clock time it was sent at.
+ *
+ * Usage: mpirun -np 2 3PC-bench-wakeup simple|optimized|shared-memory busy-poll|backoff [IDLE_MILLIS] [WAKEUPS]
+ */
+
+namespace {
+    const std::chrono::milliseconds PAUSE_BEFORE_WAKEUP(5);
+
+    double getCpuSeconds() {
+        rusage usage {};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    }
+
+    long nowInNanoseconds() {
+        using namespace std::chrono;
+        return static_cast<long>(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+    }
+
+    /**
+     * Receives on the default tag, as the processes do, which the shared memory transport can wait for on a futex.
+     */
+    template <typename Communicator>
+    int run(Communicator& communicator, const std::string& name, long idleMillis, int wakeups) {
+        if (communicator.getNumberOfProcesses() != 2) {
+            std::cerr << "The benchmark needs exactly 2 processes" << std::endl;
+            return 1;
+        }
+        if (communicator.getProcessId() == 0) {
+            // Leaves the receiver idle for the whole period, with a margin for the other process to start up
+            std::this_thread::sleep_for(std::chrono::milliseconds(idleMillis + 200));
+            for (int i = 0; i < wakeups; ++i) {
+                std::this_thread::sleep_for(PAUSE_BEFORE_WAKEUP);
+                communicator.send(i, MessageType::HEARTBEAT, std::to_string(nowInNanoseconds()), 1, communicator.getDefaultTag());
+            }
+            return 0;
+        }
+
+        const double idleStartCpu = getCpuSeconds();
+        const auto idleStart = std::chrono::steady_clock::now();
+        if (communicator.receive(idleMillis, communicator.getDefaultTag()).has_value()) {
+            std::cerr << "Received a packet while idle" << std::endl;
+            return 1;
+        }
+        const double idleSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - idleStart).count();
+        const double idleCpu = getCpuSeconds() - idleStartCpu;
+
+        LatencyRecorder latencies;
+        for (int i = 0; i < wakeups; ++i) {
+            Packet packet = communicator.receive(communicator.getDefaultTag());
+            const long sentAt = std::stol(std::string(packet.message));
+            latencies.record(std::chrono::nanoseconds(nowInNanoseconds() - sentAt));
+        }
+        std::cout << util::concat("[Benchmark] ", name, ": CPU ", idleCpu / idleSeconds,
+                                  " s per idle second, wakeup latency ", latencies.summary()) << std::endl;
+        return 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3 or (std::strcmp(argv[2], "busy-poll") != 0 and std::strcmp(argv[2], "backoff") != 0)) {
+        std::cerr << "Usage: mpirun -np 2 3PC-bench-wakeup simple|optimized|shared-memory busy-poll|backoff [IDLE_MILLIS] [WAKEUPS]" << std::endl;
+        return 1;
+    }
+    const WaitStrategy waitStrategy = std::strcmp(argv[2], "busy-poll") == 0 ? WaitStrategy::BUSY_POLL : WaitStrategy::BACKOFF;
+    const long idleMillis = argc > 3 ? std::stol(argv[3]) : 2000;
+    const int wakeups = argc > 4 ? std::stoi(argv[4]) : 200;
+    const std::string transport = argv[1];
+    const std::string name = transport + " " + argv[2];
+    if (transport == "simple") {
+        MpiSimpleCommunicator communicator(argc, argv, waitStrategy);
+        return run(communicator, name, idleMillis, wakeups);
+    } else if (transport == "optimized") {
+        MpiOptimizedCommunicator communicator(argc, argv, waitStrategy);
+        return run(communicator, name, idleMillis, wakeups);
+    } else if (transport == "shared-memory") {
+        SharedMemoryCommunicator communicator(waitStrategy);
+        return run(communicator, name, idleMillis, wakeups);
+    }
+    std::cerr << "Unknown communicator " << transport << std::endl;
+    return 1;
+}
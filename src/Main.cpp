@@ -1,18 +1,164 @@
 #include <communication/MpiOptimizedCommunicator.h>
+#include <communication/MpiCollectiveVoting.h>
+#include <communication/SharedMemoryCommunicator.h>
+#include <communication/InProcessCommunicator.h>
+#include <communication/SimulatedCommunicator.h>
 #include <processes/Coordinator.h>
 #include <processes/CohortMember.h>
+#include <logging/Timeline.h>
 
 
-int main(int argc, char** argv) {
-    auto communicator = std::make_shared<MpiOptimizedCommunicator>(argc, argv);
-    Logger::init(communicator);
-    Logger::registerThread("Main ");
+void initLogger(const std::shared_ptr<ICommunicator>& communicator) {
+    const auto& configuration = Configuration::get();
+    Logger::init(communicator, configuration.logging, configuration.consoleLog);
+    if (not configuration.tracePrefix.empty()) {
+        Logger::openTrace(util::concat(configuration.tracePrefix, ".", communicator->getProcessId(), ".bin"));
+    }
+    if (not configuration.timelinePrefix.empty()) {
+        Timeline::open(util::concat(configuration.timelinePrefix, ".", communicator->getProcessId(), ".json"));
+    }
+}
 
+void shutdownLogger() {
+    Logger::shutdown();
+    Timeline::close();
+}
+
+template <typename Tag>
+void runProcess(std::shared_ptr<ITaggedCommunicator<Tag>> communicator, Tag defaultTag, Tag crashTag, Tag heartbeatTag,
+                std::shared_ptr<ICollectiveVoting> collectiveVoting = nullptr) {
+    Logger::registerThread("Main ", communicator);
     if (communicator->getProcessId() == COORDINATOR_ID) {
-        Coordinator<MpiTag> coordinator(communicator, MPI_DEFAULT_TAG, MPI_CRASH_TAG);
+        Coordinator<Tag> coordinator(communicator, defaultTag, crashTag, heartbeatTag, collectiveVoting);
         coordinator.run();
+        coordinator.writeMetrics();
     } else {
-        CohortMember<MpiTag> cohortMember(communicator, MPI_DEFAULT_TAG, MPI_CRASH_TAG);
+        CohortMember<Tag> cohortMember(communicator, defaultTag, crashTag, heartbeatTag, collectiveVoting);
         cohortMember.run();
+        cohortMember.writeMetrics();
+    }
+}
+
+template <typename Tag>
+void run(std::shared_ptr<ITaggedCommunicator<Tag>> communicator, Tag defaultTag, Tag crashTag, Tag heartbeatTag,
+         std::shared_ptr<ICollectiveVoting> collectiveVoting = nullptr) {
+    initLogger(communicator);
+    runProcess(communicator, defaultTag, crashTag, heartbeatTag, std::move(collectiveVoting));
+    shutdownLogger();
+}
+
+/**
+ * Runs the whole cluster in this process, every participant on a thread of its own. All entries go to a single log.
+ */
+void runInProcess() {
+    const auto& configuration = Configuration::get();
+    auto communicators = InProcessCommunicator::createCluster(configuration.processes, configuration.waitStrategy);
+    initLogger(communicators[COORDINATOR_ID]);
+    std::vector<std::thread> participants;
+    for (const auto& communicator : communicators) {
+        participants.emplace_back([communicator] {
+            runProcess<InProcessTag>(communicator, InProcessTag::DEFAULT, InProcessTag::CRASH, InProcessTag::HEARTBEAT);
+        });
+    }
+    for (auto& participant : participants) {
+        participant.join();
+    }
+    shutdownLogger();
+}
+
+template <typename Process>
+void runSimulatedProcess(const std::shared_ptr<SimulatedCommunicator>& communicator) {
+    communicator->attach();
+    Logger::registerThread("Main ", communicator);
+    Process process(communicator, SimulatedTag::DEFAULT, SimulatedTag::CRASH, SimulatedTag::HEARTBEAT);
+    process.run();
+    process.writeMetrics();
+    // The crash signal receiver and the failure detector are woken up in virtual time, so this has to happen before
+    // the thread leaves the simulation
+    process.stop();
+    communicator->detach();
+}
+
+/**
+ * Runs the whole cluster on a simulated network in virtual time and reports how fast the simulation went.
+ */
+void runSimulation() {
+    using namespace std::chrono;
+    const auto& configuration = Configuration::get();
+    NetworkConditions conditions {milliseconds(configuration.minLatency), milliseconds(configuration.maxLatency),
+                                  microseconds(configuration.messageCost), configuration.lossPercent, configuration.reordering};
+    // Every process runs its main thread, a crash signal receiver and possibly a failure detector
+    const unsigned threadsPerProcess = configuration.failureDetector ? 3 : 2;
+    auto network = std::make_shared<SimulatedNetwork>(configuration.processes, threadsPerProcess, conditions, configuration.seed.value());
+    for (const auto& crash : configuration.crashes) {
+        network->scheduleCrash(crash.processId, milliseconds(crash.timeMillis));
+    }
+    auto communicators = SimulatedCommunicator::createCluster(network);
+    initLogger(communicators[COORDINATOR_ID]);
+
+    auto start = steady_clock::now();
+    std::vector<std::thread> participants;
+    for (const auto& communicator : communicators) {
+        participants.emplace_back([communicator] {
+            if (communicator->getProcessId() == COORDINATOR_ID) {
+                runSimulatedProcess<Coordinator<SimulatedTag>>(communicator);
+            } else {
+                runSimulatedProcess<CohortMember<SimulatedTag>>(communicator);
+            }
+        });
+    }
+    network->awaitCompletion();
+    for (auto& participant : participants) {
+        participant.join();
+    }
+    shutdownLogger();
+
+    double realSeconds = duration<double>(steady_clock::now() - start).count();
+    double virtualSeconds = duration<double>(network->getElapsedTime()).count();
+    std::cout << util::concat("[Simulation] Seed ", configuration.seed.value(), ": ", virtualSeconds, " s of virtual time in ",
+                              realSeconds * 1000, " ms (", virtualSeconds / realSeconds, " virtual s per s), ",
+                              network->getEventCount(), " events, ", network->getDeliveredMessageCount(), " messages delivered, ",
+                              network->getLostMessageCount(), " lost") << std::endl;
+}
+
+int main(int argc, char** argv) {
+    // Parsed before MPI_Init, as the transport decides whether MPI is initialized at all and the wait strategy is
+    // a constructor argument. That is safe: Open MPI hands its own options to the processes through the environment, so
+    // argv only holds ours. Every rank parses the same arguments, so an invalid one makes all of them exit before any
+    // waits for the others in MPI_Init.
+    try {
+        Configuration::load(argc, argv);
+    } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    const auto& configuration = Configuration::get();
+
+    if (configuration.transport == Transport::SIMULATED) {
+        runSimulation();
+        return 0;
+    }
+    if (configuration.transport == Transport::IN_PROCESS) {
+        runInProcess();
+        return 0;
+    }
+    if (configuration.transport == Transport::SHARED_MEMORY) {
+        std::shared_ptr<SharedMemoryCommunicator> communicator;
+        try {
+            communicator = std::make_shared<SharedMemoryCommunicator>(configuration.waitStrategy);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        run<SharedMemoryTag>(communicator, SharedMemoryTag::DEFAULT, SharedMemoryTag::CRASH, SharedMemoryTag::HEARTBEAT);
+        return 0;
+    }
+
+    auto communicator = std::make_shared<MpiOptimizedCommunicator>(argc, argv, configuration.waitStrategy);
+    std::shared_ptr<ICollectiveVoting> collectiveVoting;
+    if (configuration.voteGathering == VoteGathering::COLLECTIVE) {
+        // One channel per transaction allowed in flight
+        collectiveVoting = std::make_shared<MpiCollectiveVoting>(communicator, configuration.concurrentTransactions);
     }
+    run<MpiTag>(communicator, MPI_DEFAULT_TAG, MPI_CRASH_TAG, MPI_HEARTBEAT_TAG, std::move(collectiveVoting));
 }
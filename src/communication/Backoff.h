@@ -0,0 +1,70 @@
+#ifndef INC_3PC_BACKOFF_H
+#define INC_3PC_BACKOFF_H
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <util/Define.h>
+
+/**
+ * Decides what a thread does between two unsuccessful polls of a non-blocking operation.
+ */
+enum class WaitStrategy : unsigned char {
+    /** Poll continuously. Lowest wakeup latency, but occupies a whole core for the entire wait. */
+    BUSY_POLL,
+    /** Spin briefly, then yield, then sleep for exponentially growing periods capped by the maximum backoff. */
+    BACKOFF
+};
+
+/**
+ * Parks the calling thread between polls according to a WaitStrategy. One instance should be used per wait.
+ */
+class Backoff {
+public:
+
+    explicit Backoff(WaitStrategy strategy, std::chrono::microseconds maxSleep = std::chrono::microseconds(MAX_BACKOFF_MICROS))
+        : strategy(strategy), maxSleep(maxSleep) { }
+
+    void pause() {
+        if (strategy == WaitStrategy::BUSY_POLL) {
+            return;
+        }
+        if (attempts < SPIN_ATTEMPTS) {
+            ++attempts;
+        } else if (attempts < SPIN_ATTEMPTS + YIELD_ATTEMPTS) {
+            ++attempts;
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(currentSleep);
+            currentSleep = std::min(currentSleep * 2, maxSleep);
+        }
+    }
+
+    /**
+     * Polls until the given function reports completion or the deadline passes.
+     * @param poll Callable returning true once the awaited operation has completed
+     * @param deadline Point in time after which the wait is given up
+     * @return Whether the operation completed before the deadline
+     */
+    template <typename Poll>
+    bool pollUntil(Poll poll, std::chrono::steady_clock::time_point deadline) {
+        while (not poll()) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            pause();
+        }
+        return true;
+    }
+
+private:
+    static constexpr unsigned SPIN_ATTEMPTS = 64;
+    static constexpr unsigned YIELD_ATTEMPTS = 16;
+
+    WaitStrategy strategy;
+    std::chrono::microseconds maxSleep;
+    std::chrono::microseconds currentSleep {1};
+    unsigned attempts = 0;
+};
+
+#endif //INC_3PC_BACKOFF_H
@@ -0,0 +1,74 @@
+#ifndef INC_3PC_ICOLLECTIVEVOTING_H
+#define INC_3PC_ICOLLECTIVEVOTING_H
+
+#include "ICommunicator.h"
+
+/**
+ * How the coordinator's requests reach the cohort and the cohort's responses reach the coordinator.
+ */
+enum class VoteGathering : unsigned char {
+    /** A separate message to and from every cohort member */
+    POINT_TO_POINT,
+    /** One broadcast per request and one gather of all the responses, see ICollectiveVoting */
+    COLLECTIVE
+};
+
+/**
+ * Transport for the two message patterns of every 3PC phase as collective operations: a request of the coordinator
+ * broadcast to the whole cohort and the responses of all cohort members gathered at the coordinator. Completed
+ * operations are returned by poll() as ordinary packets, so the processes handle them like point-to-point messages.
+ *
+ * Every transaction maps to a channel, which carries one transaction at a time. Every process has to acquire
+ * the channel before the first operation of a transaction and release it after the last one, and has to issue
+ * the operations of a transaction in the same order (a request is followed by the gathering of responses).
+ *
+ * Collective operations cannot be cancelled. A process which stops waiting for one (e.g. because of a timeout) has to
+ * retire the channel, after which the transactions mapped to it fall back to point-to-point messages.
+ */
+class ICollectiveVoting {
+public:
+
+    virtual ~ICollectiveVoting() = default;
+
+    /**
+     * Occupies the channel of the given transaction.
+     * @return False if the channel is retired or still occupied by an earlier transaction
+     */
+    virtual bool tryAcquire(TransactionId transactionId) = 0;
+
+    virtual void release(TransactionId transactionId) = 0;
+
+    virtual void retire(TransactionId transactionId) = 0;
+
+    virtual bool isRetired(TransactionId transactionId) = 0;
+
+    /**
+     * Broadcasts a request to the cohort. May only be called by the coordinator.
+     * @return The sent packet
+     */
+    virtual Packet broadcast(TransactionId transactionId, MessageType messageType) = 0;
+
+    /**
+     * Starts gathering the responses to the last request. May only be called by the coordinator.
+     */
+    virtual void gather(TransactionId transactionId) = 0;
+
+    /**
+     * Starts waiting for the next request of the coordinator. May only be called by a cohort member.
+     */
+    virtual void expectBroadcast(TransactionId transactionId) = 0;
+
+    /**
+     * Contributes a response to the gathering of responses. May only be called by a cohort member.
+     * @return The sent packet
+     */
+    virtual Packet respond(TransactionId transactionId, MessageType messageType, const std::string& message) = 0;
+
+    /**
+     * Progresses pending operations without blocking.
+     * @return The next received packet, if any
+     */
+    virtual std::optional<Packet> poll() = 0;
+};
+
+#endif //INC_3PC_ICOLLECTIVEVOTING_H
@@ -1,22 +1,37 @@
 #ifndef INC_3PC_ICOMMUNICATOR_H
 #define INC_3PC_ICOMMUNICATOR_H
 
+#include <chrono>
+#include <limits>
 #include <optional>
-#include <unordered_set>
+#include <thread>
 #include <util/Define.h>
 #include <util/Utils.h>
+#include <util/BufferPool.h>
+#include <util/Metrics.h>
+#include <util/RankSet.h>
+#include "LamportClock.h"
 
 using ProcessId = int;
-using LamportTime = unsigned long;
+using TransactionId = unsigned;
 
+/**
+ * Move-only, as the message is a view into the buffer the packet was received into. Packets must not outlive
+ * the communicator which created them.
+ */
 struct Packet {
+    /** Time of the send event at the sender, which a receiver merges into its clock but leaves in the packet */
     LamportTime lamportTime;
     ProcessId source;
+    TransactionId transactionId;
     MessageType messageType;
-    std::string message;
+    std::string_view message;
+    /** Storage the message points into */
+    PooledBuffer buffer;
 
     inline bool operator==(const Packet &other) const {
-        return source == other.source && messageType == other.messageType && message == other.message;
+        return source == other.source && transactionId == other.transactionId && messageType == other.messageType
+               && message == other.message;
     }
 
     inline bool operator<(const Packet &other) const {
@@ -29,7 +44,7 @@ namespace std {
     struct hash<Packet> {
         inline std::size_t operator()(const Packet& packet) const {
             std::size_t hash = 0;
-            hashCombine(hash, packet.source, packet.messageType, packet.message);
+            hashCombine(hash, packet.source, packet.transactionId, packet.messageType, packet.message);
             return hash;
         }
     };
@@ -38,14 +53,16 @@ namespace std {
 class ICommunicator {
 public:
 
-    virtual Packet send(MessageType messageType, const std::string& message, const std::unordered_set<ProcessId>& recipients) = 0;
+    virtual Packet send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                        const RankSet& recipients) = 0;
 
-    virtual Packet send(MessageType messageType, const std::string& message, ProcessId recipient) {
-        return send(messageType, message, std::unordered_set<ProcessId> {recipient});
-    };
+    /**
+     * Sends to a single recipient without building a set of recipients first.
+     */
+    virtual Packet send(TransactionId transactionId, MessageType messageType, const std::string& message, ProcessId recipient) = 0;
 
-    virtual Packet sendOthers(MessageType messageType, const std::string& message) {
-        return send(messageType, message, otherProcesses);
+    virtual Packet sendOthers(TransactionId transactionId, MessageType messageType, const std::string& message) {
+        return send(transactionId, messageType, message, otherProcesses);
     };
 
     virtual Packet receive() = 0;
@@ -60,8 +77,41 @@ public:
         return numberOfProcesses;
     }
 
+    /**
+     * @return Size in bytes of the largest message the communicator can send
+     */
+    virtual std::size_t getMaxMessageSize() const {
+        return std::numeric_limits<std::size_t>::max();
+    }
+
     virtual LamportTime getCurrentLamportTime() {
-        return currentLamportTime;
+        return lamportClock.get();
+    }
+
+    /**
+     * Clock of the protocol deadlines and latencies. Simulated communicators replace it with virtual time.
+     */
+    virtual std::chrono::steady_clock::time_point now() {
+        return std::chrono::steady_clock::now();
+    }
+
+    /**
+     * Pauses the calling thread, in the time of now().
+     */
+    virtual void sleepFor(std::chrono::milliseconds duration) {
+        std::this_thread::sleep_for(duration);
+    }
+
+    LamportClock& getLamportClock() {
+        return lamportClock;
+    }
+
+    BufferPool& getBufferPool() {
+        return bufferPool;
+    }
+
+    CommunicationCounters& getCounters() {
+        return counters;
     }
 
 protected:
@@ -70,9 +120,13 @@ protected:
 
     ProcessId numberOfProcesses;
 
-    std::unordered_set<ProcessId> otherProcesses;
+    RankSet otherProcesses;
+
+    LamportClock lamportClock;
+
+    BufferPool bufferPool;
 
-    LamportTime currentLamportTime;
+    CommunicationCounters counters;
 };
 
 #endif //INC_3PC_ICOMMUNICATOR_H
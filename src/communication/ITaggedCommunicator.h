@@ -7,18 +7,26 @@ template <typename Tag>
 class ITaggedCommunicator : public ICommunicator {
 public:
 
-    virtual Packet send(MessageType messageType, const std::string& message, const std::unordered_set<ProcessId>& recipients, Tag tag) = 0;
+    using ICommunicator::send;
+    using ICommunicator::sendOthers;
 
-    Packet send(MessageType messageType, const std::string& message, const std::unordered_set<ProcessId>& recipients) override {
-        return send(messageType, message, recipients, getDefaultTag());
+    virtual Packet send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                        const RankSet& recipients, Tag tag) = 0;
+
+    Packet send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                const RankSet& recipients) override {
+        return send(transactionId, messageType, message, recipients, getDefaultTag());
     }
 
-    virtual Packet send(MessageType messageType, const std::string& message, ProcessId recipient, Tag tag) {
-        return send(messageType, message, std::unordered_set<ProcessId> {recipient}, tag);
-    };
+    Packet send(TransactionId transactionId, MessageType messageType, const std::string& message, ProcessId recipient) override {
+        return send(transactionId, messageType, message, recipient, getDefaultTag());
+    }
+
+    virtual Packet send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                        ProcessId recipient, Tag tag) = 0;
 
-    virtual Packet sendOthers(MessageType messageType, const std::string& message, Tag tag) {
-        return send(messageType, message, otherProcesses, tag);
+    virtual Packet sendOthers(TransactionId transactionId, MessageType messageType, const std::string& message, Tag tag) {
+        return send(transactionId, messageType, message, otherProcesses, tag);
     };
 
     virtual Packet receive(Tag tag) = 0;
@@ -0,0 +1,146 @@
+#include <array>
+#include <stdexcept>
+#include <util/StringConcat.h>
+#include "InProcessCommunicator.h"
+
+InProcessNetwork::InProcessNetwork(ProcessId numberOfProcesses) {
+    if (numberOfProcesses <= 0) {
+        throw std::invalid_argument("An in-process network needs at least one process");
+    }
+    for (ProcessId id = 0; id < numberOfProcesses; ++id) {
+        mailboxes.push_back(std::make_unique<Mailbox>());
+    }
+}
+
+InProcessCommunicator::InProcessCommunicator(std::shared_ptr<InProcessNetwork> network, ProcessId processId,
+                                             WaitStrategy waitStrategy)
+    : network(std::move(network)), waitStrategy(waitStrategy) {
+    myProcessId = processId;
+    numberOfProcesses = this->network->getNumberOfProcesses();
+    if (myProcessId < 0 or myProcessId >= numberOfProcesses) {
+        throw std::invalid_argument(util::concat("Process id ", myProcessId, " is outside of the in-process network"));
+    }
+    for (ProcessId id = 0; id < numberOfProcesses; ++id) {
+        if (id != myProcessId) {
+            otherProcesses.insert(id);
+        }
+    }
+}
+
+std::vector<std::shared_ptr<InProcessCommunicator>> InProcessCommunicator::createCluster(ProcessId numberOfProcesses,
+                                                                                        WaitStrategy waitStrategy) {
+    auto network = std::make_shared<InProcessNetwork>(numberOfProcesses);
+    std::vector<std::shared_ptr<InProcessCommunicator>> communicators;
+    for (ProcessId id = 0; id < numberOfProcesses; ++id) {
+        communicators.push_back(std::make_shared<InProcessCommunicator>(network, id, waitStrategy));
+    }
+    return communicators;
+}
+
+Packet InProcessCommunicator::send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                                   const RankSet& recipients, InProcessTag tag) {
+    return sendToAll(transactionId, messageType, message, recipients, tag);
+}
+
+Packet InProcessCommunicator::send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                                   ProcessId recipient, InProcessTag tag) {
+    return sendToAll(transactionId, messageType, message, std::array<ProcessId, 1> {recipient}, tag);
+}
+
+template <typename Recipients>
+Packet InProcessCommunicator::sendToAll(TransactionId transactionId, MessageType messageType, const std::string& message,
+                                        const Recipients& recipients, InProcessTag tag) {
+    const LamportTime lamportTime = lamportClock.tick();
+    for (ProcessId recipient : recipients) {
+        InProcessNetwork::Mailbox& mailbox = *network->mailboxes.at(static_cast<std::size_t>(recipient));
+        PooledBuffer deliveredMessage = network->bufferPool.copyOf(message);
+        {
+            std::lock_guard<std::mutex> lock(mailbox.mutex);
+            mailbox.packets[static_cast<std::size_t>(tag)].push_back(Packet {
+                    .lamportTime = lamportTime,
+                    .source = myProcessId,
+                    .transactionId = transactionId,
+                    .messageType = messageType,
+                    .message = deliveredMessage.view(),
+                    .buffer = std::move(deliveredMessage)
+            });
+        }
+        // Both the main thread and the crash signal receiver of a process may be waiting, for different tags
+        mailbox.packetArrived.notify_all();
+        counters.recordSent(1, message.size());
+    }
+
+    PooledBuffer sentMessage = bufferPool.copyOf(message);
+    return Packet {
+            .lamportTime = lamportTime,
+            .source = myProcessId,
+            .transactionId = transactionId,
+            .messageType = messageType,
+            .message = sentMessage.view(),
+            .buffer = std::move(sentMessage)
+    };
+}
+
+Packet InProcessCommunicator::receive(InProcessTag tag) {
+    return receive(-1, std::optional<InProcessTag>(tag)).value();
+}
+
+Packet InProcessCommunicator::receive() {
+    return receive(-1, std::optional<InProcessTag>()).value();
+}
+
+std::optional<Packet> InProcessCommunicator::receive(long timeoutMillis, InProcessTag tag) {
+    return receive(timeoutMillis, std::optional<InProcessTag>(tag));
+}
+
+std::optional<Packet> InProcessCommunicator::receive(long timeoutMillis) {
+    return receive(timeoutMillis, std::optional<InProcessTag>());
+}
+
+InProcessTag InProcessCommunicator::getDefaultTag() const {
+    return InProcessTag::DEFAULT;
+}
+
+std::optional<Packet> InProcessCommunicator::receive(long timeoutMillis, std::optional<InProcessTag> tag) {
+    using namespace std::chrono;
+    const auto deadline = timeoutMillis < 0 ? steady_clock::time_point::max() : steady_clock::now() + milliseconds(timeoutMillis);
+    InProcessNetwork::Mailbox& mailbox = *network->mailboxes[static_cast<std::size_t>(myProcessId)];
+    std::optional<Packet> packet;
+
+    if (waitStrategy == WaitStrategy::BUSY_POLL) {
+        Backoff backoff(waitStrategy);
+        backoff.pollUntil([&] {
+            std::lock_guard<std::mutex> lock(mailbox.mutex);
+            packet = tryReceive(mailbox, tag);
+            return packet.has_value();
+        }, deadline);
+        return packet;
+    }
+
+    std::unique_lock<std::mutex> lock(mailbox.mutex);
+    auto received = [&] {
+        packet = tryReceive(mailbox, tag);
+        return packet.has_value();
+    };
+    if (deadline == steady_clock::time_point::max()) {
+        mailbox.packetArrived.wait(lock, received);
+    } else {
+        mailbox.packetArrived.wait_until(lock, deadline, received);
+    }
+    return packet;
+}
+
+std::optional<Packet> InProcessCommunicator::tryReceive(InProcessNetwork::Mailbox& mailbox, std::optional<InProcessTag> tag) {
+    for (std::size_t tagIndex = 0; tagIndex < InProcessNetwork::TAG_COUNT; ++tagIndex) {
+        std::deque<Packet>& packets = mailbox.packets[tagIndex];
+        if ((tag.has_value() and static_cast<std::size_t>(tag.value()) != tagIndex) or packets.empty()) {
+            continue;
+        }
+        Packet packet = std::move(packets.front());
+        packets.pop_front();
+        lamportClock.merge(packet.lamportTime);
+        counters.recordReceived(packet.message.size());
+        return packet;
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,100 @@
+#ifndef INC_3PC_INPROCESSCOMMUNICATOR_H
+#define INC_3PC_INPROCESSCOMMUNICATOR_H
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "ITaggedCommunicator.h"
+#include "Backoff.h"
+
+enum class InProcessTag : unsigned char {
+    DEFAULT, CRASH, HEARTBEAT
+};
+
+/**
+ * Mailboxes of a cluster whose processes are threads of the current process. Has to outlive the packets delivered
+ * through it, which is guaranteed by every InProcessCommunicator sharing its ownership.
+ */
+class InProcessNetwork {
+public:
+
+    static constexpr std::size_t TAG_COUNT = 3;
+
+    explicit InProcessNetwork(ProcessId numberOfProcesses);
+
+    ProcessId getNumberOfProcesses() const {
+        return static_cast<ProcessId>(mailboxes.size());
+    }
+
+private:
+    friend class InProcessCommunicator;
+
+    /** Packets waiting to be received by one process, one queue per tag */
+    struct Mailbox {
+        std::mutex mutex;
+        std::condition_variable packetArrived;
+        std::deque<Packet> packets[TAG_COUNT];
+    };
+
+    /** Storage of the messages in flight, declared first so that it is destroyed after the packets in the mailboxes */
+    BufferPool bufferPool;
+    std::vector<std::unique_ptr<Mailbox>> mailboxes;
+};
+
+/**
+ * ITaggedCommunicator of one process of an InProcessNetwork. Packets are handed over to the recipient's mailbox
+ * without serialization, so a whole cluster of threads can be set up in a fraction of the startup time of mpirun.
+ */
+class InProcessCommunicator : public ITaggedCommunicator<InProcessTag> {
+public:
+
+    using ITaggedCommunicator<InProcessTag>::send;
+
+    InProcessCommunicator(std::shared_ptr<InProcessNetwork> network, ProcessId processId,
+                          WaitStrategy waitStrategy = WaitStrategy::BACKOFF);
+
+    /**
+     * @return A communicator for every process of a new network of the given size, indexed by process id
+     */
+    static std::vector<std::shared_ptr<InProcessCommunicator>> createCluster(ProcessId numberOfProcesses,
+                                                                            WaitStrategy waitStrategy = WaitStrategy::BACKOFF);
+
+    Packet send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                const RankSet& recipients, InProcessTag tag) override;
+
+    Packet send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                ProcessId recipient, InProcessTag tag) override;
+
+    Packet receive(InProcessTag tag) override;
+
+    Packet receive() override;
+
+    std::optional<Packet> receive(long timeoutMillis, InProcessTag tag) override;
+
+    std::optional<Packet> receive(long timeoutMillis) override;
+
+    InProcessTag getDefaultTag() const override;
+
+private:
+
+    template <typename Recipients>
+    Packet sendToAll(TransactionId transactionId, MessageType messageType, const std::string& message,
+                     const Recipients& recipients, InProcessTag tag);
+
+    /**
+     * Waits for a packet of the given tag, or of any tag if none is given.
+     */
+    std::optional<Packet> receive(long timeoutMillis, std::optional<InProcessTag> tag);
+
+    /**
+     * Takes the first packet of the given tag (or of any tag) out of the mailbox, which has to be locked.
+     */
+    std::optional<Packet> tryReceive(InProcessNetwork::Mailbox& mailbox, std::optional<InProcessTag> tag);
+
+    std::shared_ptr<InProcessNetwork> network;
+    WaitStrategy waitStrategy;
+};
+
+#endif //INC_3PC_INPROCESSCOMMUNICATOR_H
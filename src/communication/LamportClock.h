@@ -0,0 +1,44 @@
+#ifndef INC_3PC_LAMPORTCLOCK_H
+#define INC_3PC_LAMPORTCLOCK_H
+
+#include <algorithm>
+#include <atomic>
+
+using LamportTime = unsigned long;
+
+/**
+ * Lamport logical clock which any number of threads can tick, merge and read concurrently without locking.
+ */
+class LamportClock {
+public:
+
+    /**
+     * Advances the clock for a local event, e.g. sending a message.
+     * @return Timestamp of the event
+     */
+    LamportTime tick() {
+        return time.fetch_add(1, std::memory_order_acq_rel) + 1;
+    }
+
+    /**
+     * Advances the clock past the timestamp of a received message.
+     * @return Timestamp of the receive event
+     */
+    LamportTime merge(LamportTime receivedTime) {
+        LamportTime current = time.load(std::memory_order_relaxed);
+        LamportTime merged;
+        do {
+            merged = std::max(current, receivedTime) + 1;
+        } while (not time.compare_exchange_weak(current, merged, std::memory_order_acq_rel, std::memory_order_relaxed));
+        return merged;
+    }
+
+    LamportTime get() const {
+        return time.load(std::memory_order_acquire);
+    }
+
+private:
+    std::atomic<LamportTime> time {0};
+};
+
+#endif //INC_3PC_LAMPORTCLOCK_H
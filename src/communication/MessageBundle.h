@@ -0,0 +1,99 @@
+#ifndef INC_3PC_MESSAGEBUNDLE_H
+#define INC_3PC_MESSAGEBUNDLE_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include "ICommunicator.h"
+
+/**
+ * Protocol messages of different transactions for the same recipients, encoded into the message of a single BUNDLE
+ * packet. Every entry is the transaction id (4 bytes in the sender's byte order), the message type and the length of
+ * the message (a byte each), followed by the message itself.
+ */
+class MessageBundle {
+public:
+
+    struct Entry {
+        TransactionId transactionId;
+        MessageType messageType;
+        std::string_view message;
+    };
+
+    /**
+     * @param capacity Maximum size of the encoded bundle in bytes
+     */
+    explicit MessageBundle(std::size_t capacity) : capacity(capacity) { }
+
+    /**
+     * @return Whether an entry with the given message fits into the bundle besides the entries added so far
+     */
+    bool fits(const std::string& message) const {
+        return message.size() <= UINT8_MAX and encoded.size() + ENTRY_HEADER_SIZE + message.size() <= capacity;
+    }
+
+    /**
+     * Appends an entry, which has to fit.
+     */
+    void add(TransactionId transactionId, MessageType messageType, const std::string& message) {
+        const auto id = static_cast<uint32_t>(transactionId);
+        char header[ENTRY_HEADER_SIZE];
+        std::memcpy(header, &id, sizeof(id));
+        header[4] = static_cast<char>(messageType);
+        header[5] = static_cast<char>(message.size());
+        encoded.append(header, ENTRY_HEADER_SIZE);
+        encoded.append(message);
+        ++entries;
+    }
+
+    void clear() {
+        encoded.clear();
+        entries = 0;
+    }
+
+    bool empty() const {
+        return entries == 0;
+    }
+
+    std::size_t size() const {
+        return entries;
+    }
+
+    const std::string& getEncoded() const {
+        return encoded;
+    }
+
+    /**
+     * Calls the given function with every entry of an encoded bundle, in the order they were added. The messages of
+     * the entries are views into the encoded bundle.
+     * @return Whether the bundle was well-formed, if not the entries before the malformed one were still passed on
+     */
+    template <typename Function>
+    static bool forEachEntry(std::string_view bundle, Function function) {
+        while (not bundle.empty()) {
+            if (bundle.size() < ENTRY_HEADER_SIZE) {
+                return false;
+            }
+            uint32_t id;
+            std::memcpy(&id, bundle.data(), sizeof(id));
+            const auto messageType = static_cast<unsigned char>(bundle[4]);
+            const auto length = static_cast<unsigned char>(bundle[5]);
+            if (messageType >= static_cast<unsigned char>(MessageType::BUNDLE) or bundle.size() < ENTRY_HEADER_SIZE + length) {
+                return false;
+            }
+            function(Entry {static_cast<TransactionId>(id), static_cast<MessageType>(messageType), bundle.substr(ENTRY_HEADER_SIZE, length)});
+            bundle.remove_prefix(ENTRY_HEADER_SIZE + length);
+        }
+        return true;
+    }
+
+private:
+    static constexpr std::size_t ENTRY_HEADER_SIZE = 6;
+
+    std::size_t capacity;
+    std::string encoded;
+    std::size_t entries = 0;
+};
+
+#endif //INC_3PC_MESSAGEBUNDLE_H
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <iterator>
+#include <cstring>
+#include <stdexcept>
+#include "MpiCollectiveVoting.h"
+
+MpiCollectiveVoting::MpiCollectiveVoting(std::shared_ptr<MpiSimpleCommunicator> communicator, unsigned channels)
+    : communicator(std::move(communicator)), channels(std::max(channels, 1u)) {
+    for (Channel& channel : this->channels) {
+        MPI_Comm_dup(MPI_COMM_WORLD, &channel.communicator);
+    }
+}
+
+MpiCollectiveVoting::~MpiCollectiveVoting() {
+    // Freeing a communicator lets its pending operations finish, which still need their buffers
+    std::move(operations.begin(), operations.end(), std::back_inserter(abandoned));
+    communicator->keepUntilFinalized(std::make_shared<std::vector<Operation>>(std::move(abandoned)));
+    for (Channel& channel : channels) {
+        MPI_Comm_free(&channel.communicator);
+    }
+}
+
+bool MpiCollectiveVoting::tryAcquire(TransactionId transactionId) {
+    Channel& channel = getChannel(transactionId);
+    if (channel.retired or channel.transactionId.has_value()) {
+        return false;
+    }
+    channel.transactionId = transactionId;
+    return true;
+}
+
+void MpiCollectiveVoting::release(TransactionId transactionId) {
+    Channel& channel = getChannel(transactionId);
+    if (channel.transactionId == transactionId) {
+        channel.transactionId = std::nullopt;
+    }
+}
+
+void MpiCollectiveVoting::retire(TransactionId transactionId) {
+    Channel& channel = getChannel(transactionId);
+    channel.retired = true;
+    channel.transactionId = std::nullopt;
+    // Nobody waits for the pending operations of the channel any longer, but MPI may still complete them
+    auto retired = std::stable_partition(operations.begin(), operations.end(), [&](const Operation& operation) {
+        return &getChannel(operation.transactionId) != &channel;
+    });
+    std::move(retired, operations.end(), std::back_inserter(abandoned));
+    operations.erase(retired, operations.end());
+}
+
+bool MpiCollectiveVoting::isRetired(TransactionId transactionId) {
+    return getChannel(transactionId).retired;
+}
+
+Packet MpiCollectiveVoting::broadcast(TransactionId transactionId, MessageType messageType) {
+    Operation& operation = operations.emplace_back(Operation {MPI_REQUEST_NULL, transactionId, OperationKind::BROADCAST_SEND,
+                                                              {toCollectiveMessage(messageType, "")}});
+    MPI_Ibcast(operation.buffer.data(), sizeof(CollectiveMessage), MPI_BYTE, COORDINATOR_ID,
+               getChannel(transactionId).communicator, &operation.request);
+    communicator->getCounters().recordSent(static_cast<uint64_t>(communicator->getNumberOfProcesses() - 1),
+                                           sizeof(CollectiveMessage));
+    return toPacket(operation.buffer.front(), communicator->getProcessId(), transactionId);
+}
+
+void MpiCollectiveVoting::gather(TransactionId transactionId) {
+    Operation& operation = operations.emplace_back(Operation {MPI_REQUEST_NULL, transactionId, OperationKind::GATHER_RECEIVE,
+                                                              std::vector<CollectiveMessage>(communicator->getNumberOfProcesses())});
+    MPI_Igather(MPI_IN_PLACE, sizeof(CollectiveMessage), MPI_BYTE, operation.buffer.data(), sizeof(CollectiveMessage),
+                MPI_BYTE, COORDINATOR_ID, getChannel(transactionId).communicator, &operation.request);
+}
+
+void MpiCollectiveVoting::expectBroadcast(TransactionId transactionId) {
+    Operation& operation = operations.emplace_back(Operation {MPI_REQUEST_NULL, transactionId, OperationKind::BROADCAST_RECEIVE,
+                                                              std::vector<CollectiveMessage>(1)});
+    MPI_Ibcast(operation.buffer.data(), sizeof(CollectiveMessage), MPI_BYTE, COORDINATOR_ID,
+               getChannel(transactionId).communicator, &operation.request);
+}
+
+Packet MpiCollectiveVoting::respond(TransactionId transactionId, MessageType messageType, const std::string& message) {
+    Operation& operation = operations.emplace_back(Operation {MPI_REQUEST_NULL, transactionId, OperationKind::GATHER_SEND,
+                                                              {toCollectiveMessage(messageType, message)}});
+    MPI_Igather(operation.buffer.data(), sizeof(CollectiveMessage), MPI_BYTE, nullptr, 0, MPI_BYTE, COORDINATOR_ID,
+                getChannel(transactionId).communicator, &operation.request);
+    communicator->getCounters().recordSent(1, sizeof(CollectiveMessage));
+    return toPacket(operation.buffer.front(), communicator->getProcessId(), transactionId);
+}
+
+std::optional<Packet> MpiCollectiveVoting::poll() {
+    pollAbandoned();
+    if (receivedPackets.empty()) {
+        // Completed operations are removed in place so that the remaining ones keep their order
+        std::size_t remaining = 0;
+        for (Operation& operation : operations) {
+            int completed;
+            MPI_Test(&operation.request, &completed, MPI_STATUS_IGNORE);
+            if (completed) {
+                complete(operation);
+            } else {
+                if (&operations[remaining] != &operation) {
+                    operations[remaining] = std::move(operation);
+                }
+                ++remaining;
+            }
+        }
+        operations.resize(remaining);
+    }
+    if (receivedPackets.empty()) {
+        return std::nullopt;
+    }
+    Packet packet = std::move(receivedPackets.front());
+    receivedPackets.pop_front();
+    return packet;
+}
+
+void MpiCollectiveVoting::pollAbandoned() {
+    abandoned.erase(std::remove_if(abandoned.begin(), abandoned.end(), [](Operation& operation) {
+        int completed;
+        MPI_Test(&operation.request, &completed, MPI_STATUS_IGNORE);
+        return completed != 0;
+    }), abandoned.end());
+}
+
+MpiCollectiveVoting::Channel& MpiCollectiveVoting::getChannel(TransactionId transactionId) {
+    return channels[transactionId % channels.size()];
+}
+
+CollectiveMessage MpiCollectiveVoting::toCollectiveMessage(MessageType messageType, const std::string& message) {
+    if (message.size() > COLLECTIVE_MESSAGE_SIZE) {
+        throw std::invalid_argument("Message '" + message + "' is too long to be sent collectively");
+    }
+    CollectiveMessage collectiveMessage {};
+    collectiveMessage.lamportTime = static_cast<EncodedLamportTime>(communicator->getLamportClock().tick());
+    collectiveMessage.messageType = static_cast<EncodedMessageType>(messageType);
+    collectiveMessage.messageLength = static_cast<uint8_t>(message.size());
+    std::memcpy(collectiveMessage.message, message.data(), message.size());
+    return collectiveMessage;
+}
+
+Packet MpiCollectiveVoting::toPacket(const CollectiveMessage& collectiveMessage, ProcessId source, TransactionId transactionId) {
+    PooledBuffer message = communicator->getBufferPool().copyOf({collectiveMessage.message, collectiveMessage.messageLength});
+    return Packet {
+            .lamportTime = static_cast<LamportTime>(collectiveMessage.lamportTime),
+            .source = source,
+            .transactionId = transactionId,
+            .messageType = static_cast<MessageType>(collectiveMessage.messageType),
+            .message = message.view(),
+            .buffer = std::move(message)
+    };
+}
+
+void MpiCollectiveVoting::complete(const Operation& operation) {
+    switch (operation.kind) {
+        case OperationKind::BROADCAST_RECEIVE: {
+            Packet packet = toPacket(operation.buffer.front(), COORDINATOR_ID, operation.transactionId);
+            communicator->getLamportClock().merge(packet.lamportTime);
+            communicator->getCounters().recordReceived(sizeof(CollectiveMessage));
+            receivedPackets.push_back(std::move(packet));
+            break;
+        }
+        case OperationKind::GATHER_RECEIVE: {
+            for (ProcessId source = 0; source < static_cast<ProcessId>(operation.buffer.size()); ++source) {
+                if (source != COORDINATOR_ID) {
+                    Packet packet = toPacket(operation.buffer[source], source, operation.transactionId);
+                    communicator->getLamportClock().merge(packet.lamportTime);
+                    communicator->getCounters().recordReceived(sizeof(CollectiveMessage));
+                    receivedPackets.push_back(std::move(packet));
+                }
+            }
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
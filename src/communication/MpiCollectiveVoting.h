@@ -0,0 +1,100 @@
+#ifndef INC_3PC_MPICOLLECTIVEVOTING_H
+#define INC_3PC_MPICOLLECTIVEVOTING_H
+
+#include <deque>
+#include <memory>
+#include <vector>
+#include "ICollectiveVoting.h"
+#include "MpiSimpleCommunicator.h"
+
+#define COLLECTIVE_MESSAGE_SIZE 6
+
+/**
+ * Fixed-size element of the broadcasts and gathers. Messages are limited to COLLECTIVE_MESSAGE_SIZE characters.
+ */
+struct CollectiveMessage {
+    EncodedLamportTime lamportTime;
+    EncodedMessageType messageType;
+    uint8_t messageLength;
+    char message[COLLECTIVE_MESSAGE_SIZE];
+};
+
+/**
+ * ICollectiveVoting built on MPI_Ibcast and MPI_Igather. Every channel is a duplicate of MPI_COMM_WORLD, created once
+ * at startup, and transaction t uses channel t mod the number of channels.
+ */
+class MpiCollectiveVoting : public ICollectiveVoting {
+public:
+
+    /**
+     * Creates the channels. Collective over MPI_COMM_WORLD, so every process has to call it.
+     */
+    MpiCollectiveVoting(std::shared_ptr<MpiSimpleCommunicator> communicator, unsigned channels);
+
+    ~MpiCollectiveVoting() override;
+
+    bool tryAcquire(TransactionId transactionId) override;
+
+    void release(TransactionId transactionId) override;
+
+    void retire(TransactionId transactionId) override;
+
+    bool isRetired(TransactionId transactionId) override;
+
+    Packet broadcast(TransactionId transactionId, MessageType messageType) override;
+
+    void gather(TransactionId transactionId) override;
+
+    void expectBroadcast(TransactionId transactionId) override;
+
+    Packet respond(TransactionId transactionId, MessageType messageType, const std::string& message) override;
+
+    std::optional<Packet> poll() override;
+
+private:
+
+    struct Channel {
+        MPI_Comm communicator;
+        std::optional<TransactionId> transactionId;
+        bool retired = false;
+    };
+
+    enum class OperationKind {
+        BROADCAST_SEND, BROADCAST_RECEIVE, GATHER_SEND, GATHER_RECEIVE
+    };
+
+    struct Operation {
+        MPI_Request request;
+        TransactionId transactionId;
+        OperationKind kind;
+        /** One element for broadcasts and contributions, one per process for gathers at the coordinator */
+        std::vector<CollectiveMessage> buffer;
+    };
+
+    Channel& getChannel(TransactionId transactionId);
+
+    CollectiveMessage toCollectiveMessage(MessageType messageType, const std::string& message);
+
+    Packet toPacket(const CollectiveMessage& collectiveMessage, ProcessId source, TransactionId transactionId);
+
+    void complete(const Operation& operation);
+
+    /**
+     * Tests the abandoned operations and drops the ones which completed, as MPI no longer uses their buffers.
+     */
+    void pollAbandoned();
+
+    std::shared_ptr<MpiSimpleCommunicator> communicator;
+    std::vector<Channel> channels;
+    /** Operations in the order they were started */
+    std::vector<Operation> operations;
+    /**
+     * Operations of retired channels. A pending collective operation can be neither cancelled nor freed, so MPI may still
+     * write into its buffer: it is kept until the operation completes, and at the latest until MPI is finalized.
+     */
+    std::vector<Operation> abandoned;
+    /** Packets of completed operations not yet returned by poll() */
+    std::deque<Packet> receivedPackets;
+};
+
+#endif //INC_3PC_MPICOLLECTIVEVOTING_H
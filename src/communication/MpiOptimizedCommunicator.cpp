@@ -1,96 +1,94 @@
+#include <array>
 #include "MpiOptimizedCommunicator.h"
 
-Packet MpiOptimizedCommunicator::send(MessageType messageType, const std::string& message,
-                                      const std::unordered_set<ProcessId>& recipients, MpiTag tag) {
-
-    std::lock_guard<std::recursive_mutex> lock(communicationMutex);
-    std::string finalMessage = encode(++currentLamportTime, messageType, message);
+template <typename Recipients>
+Packet MpiOptimizedCommunicator::sendToAll(TransactionId transactionId, MessageType messageType, const std::string& message,
+                                           const Recipients& recipients, MpiTag tag) {
 
+    PooledBuffer finalMessage = encode(lamportClock.tick(), transactionId, messageType, message);
+    // Reused between the calls to keep sending free of allocations
+    thread_local std::vector<MPI_Request> requests;
+    requests.clear();
     for (ProcessId recipient : recipients) {
-        MPI_Send(finalMessage.c_str(), static_cast<int>(finalMessage.size()), MPI_BYTE, recipient, tag, MPI_COMM_WORLD);
+        MPI_Isend(finalMessage.data(), static_cast<int>(finalMessage.size()), MPI_BYTE, recipient, tag, MPI_COMM_WORLD,
+                  &requests.emplace_back());
     }
+    waitForAll(requests);
+    counters.recordSent(recipients.size(), finalMessage.size());
 
-    return Packet {
-            .lamportTime = currentLamportTime,
-            .source = myProcessId,
-            .messageType = messageType,
-            .message = message
-    };
+    return getPacket(std::move(finalMessage), myProcessId);
 }
 
-Packet MpiOptimizedCommunicator::receive(MpiTag tag) {
-    MPI_Status status;
-    int messageLength;
-
-    MPI_Probe(MPI_ANY_SOURCE, tag, MPI_COMM_WORLD, &status);
-    MPI_Get_count(&status, MPI_BYTE, &messageLength);
+Packet MpiOptimizedCommunicator::send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                                      const RankSet& recipients, MpiTag tag) {
+    return sendToAll(transactionId, messageType, message, recipients, tag);
+}
 
-    ProcessId source = status.MPI_SOURCE;
-    std::string message;
-    message.resize(static_cast<unsigned long>(messageLength));
-    MPI_Recv(message.data(), messageLength, MPI_BYTE, source, tag, MPI_COMM_WORLD, &status);
+Packet MpiOptimizedCommunicator::send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                                      ProcessId recipient, MpiTag tag) {
+    return sendToAll(transactionId, messageType, message, std::array<ProcessId, 1> {recipient}, tag);
+}
 
-    Packet packet = getPacket(message, source);
-    updateTimestamp(packet);
-    return packet;
+Packet MpiOptimizedCommunicator::receive(MpiTag tag) {
+    return receive(-1, tag).value();
 }
 
 std::optional<Packet> MpiOptimizedCommunicator::receive(long timeoutMillis, MpiTag tag) {
-    using namespace std::chrono;
     MPI_Status status;
-    int hasReceivedData;
-    auto timeStarted = system_clock::now();
 
-    do {
-        MPI_Iprobe(MPI_ANY_SOURCE, tag, MPI_COMM_WORLD, &hasReceivedData, &status);
-    } while (not hasReceivedData &&
-             duration_cast<milliseconds>(system_clock::now() - timeStarted).count() < timeoutMillis);
-    if (not hasReceivedData) {
+    if (not probeUntil(tag, status, deadlineAfter(timeoutMillis))) {
         return std::nullopt;
     }
 
     ProcessId source = status.MPI_SOURCE;
     int messageLength;
     MPI_Get_count(&status, MPI_BYTE, &messageLength);
-    std::string message;
-    message.resize(static_cast<unsigned long>(messageLength));
+    PooledBuffer message = bufferPool.acquire(static_cast<std::size_t>(messageLength));
     MPI_Recv(message.data(), messageLength, MPI_BYTE, source, tag, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
 
-    Packet packet = getPacket(message, source);
+    Packet packet = getPacket(std::move(message), source);
     updateTimestamp(packet);
+    counters.recordReceived(static_cast<uint64_t>(messageLength));
     return packet;
 }
 
-std::string MpiOptimizedCommunicator::encode(LamportTime lamportTime, MessageType messageType, const std::string& message) {
-    std::string finalMessage;
+PooledBuffer MpiOptimizedCommunicator::encode(LamportTime lamportTime, TransactionId transactionId, MessageType messageType,
+                                              const std::string& message) {
     const auto encodedLamportTime = static_cast<EncodedLamportTime>(lamportTime);
+    const auto encodedTransactionId = static_cast<EncodedTransactionId>(transactionId);
     const auto encodedMessageType = static_cast<EncodedMessageType>(messageType);
-    finalMessage.resize(sizeof(encodedLamportTime) + sizeof(encodedMessageType) + message.size());
+    const auto transactionIdOffset = sizeof(encodedLamportTime);
+    const auto messageTypeOffset = transactionIdOffset + sizeof(encodedTransactionId);
+    const auto headerSize = messageTypeOffset + sizeof(encodedMessageType);
+    PooledBuffer finalMessage = bufferPool.acquire(headerSize + message.size());
     *(reinterpret_cast<EncodedLamportTime*>(finalMessage.data())) = encodedLamportTime;
-    *(reinterpret_cast<EncodedMessageType*>(finalMessage.data() + sizeof(encodedLamportTime))) = encodedMessageType;
-    message.copy(finalMessage.data() + sizeof(encodedLamportTime) + sizeof(encodedMessageType), message.size());
+    *(reinterpret_cast<EncodedTransactionId*>(finalMessage.data() + transactionIdOffset)) = encodedTransactionId;
+    *(reinterpret_cast<EncodedMessageType*>(finalMessage.data() + messageTypeOffset)) = encodedMessageType;
+    message.copy(finalMessage.data() + headerSize, message.size());
     return finalMessage;
 }
 
-Packet MpiOptimizedCommunicator::getPacket(const std::string& encodedMessage, ProcessId source) {
+Packet MpiOptimizedCommunicator::getPacket(PooledBuffer encodedMessage, ProcessId source) {
+    const auto transactionIdOffset = sizeof(EncodedLamportTime);
+    const auto messageTypeOffset = transactionIdOffset + sizeof(EncodedTransactionId);
+    const auto headerSize = messageTypeOffset + sizeof(EncodedMessageType);
     const auto lamportTime = static_cast<LamportTime>(*reinterpret_cast<const EncodedLamportTime*>(encodedMessage.data()));
-    const auto messageType = static_cast<MessageType>(*reinterpret_cast<const EncodedMessageType*>(encodedMessage.data() + sizeof(EncodedLamportTime)));
-    const auto headerSize = sizeof(EncodedLamportTime) + sizeof(EncodedMessageType);
+    const auto transactionId = static_cast<TransactionId>(*reinterpret_cast<const EncodedTransactionId*>(encodedMessage.data() + transactionIdOffset));
+    const auto messageType = static_cast<MessageType>(*reinterpret_cast<const EncodedMessageType*>(encodedMessage.data() + messageTypeOffset));
 
     return Packet {
             .lamportTime = lamportTime,
             .source = source,
+            .transactionId = transactionId,
             .messageType = messageType,
-            .message = encodedMessage.substr(headerSize)
+            .message = encodedMessage.view(headerSize),
+            .buffer = std::move(encodedMessage)
     };
 }
 
 void MpiOptimizedCommunicator::updateTimestamp(Packet& packet) {
-    {
-        std::lock_guard<std::recursive_mutex> lock(communicationMutex);
-        currentLamportTime = std::max(packet.lamportTime, currentLamportTime) + 1;
-    }
-    packet.lamportTime = currentLamportTime;
+    lamportClock.merge(packet.lamportTime);
 }
 
-MpiOptimizedCommunicator::MpiOptimizedCommunicator(int argc, char** argv) : MpiSimpleCommunicator(argc, argv) { }
+MpiOptimizedCommunicator::MpiOptimizedCommunicator(int argc, char** argv, WaitStrategy waitStrategy)
+    : MpiSimpleCommunicator(argc, argv, waitStrategy) { }
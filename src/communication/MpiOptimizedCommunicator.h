@@ -6,9 +6,15 @@
 class MpiOptimizedCommunicator : public MpiSimpleCommunicator {
 public:
 
-    MpiOptimizedCommunicator(int argc, char** argv);
+    MpiOptimizedCommunicator(int argc, char** argv, WaitStrategy waitStrategy = WaitStrategy::BACKOFF);
 
-    Packet send(MessageType messageType, const std::string& message, const std::unordered_set<ProcessId>& recipients, MpiTag tag) override;
+    using MpiSimpleCommunicator::send;
+
+    Packet send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                const RankSet& recipients, MpiTag tag) override;
+
+    Packet send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                ProcessId recipient, MpiTag tag) override;
 
     Packet receive(MpiTag tag) override;
 
@@ -16,9 +22,19 @@ public:
 
 protected:
 
-    static std::string encode(LamportTime lamportTime, MessageType messageType, const std::string& message);
+    /**
+     * Sends the packet to every recipient in the given range of process ids, which avoids building a set for a single one.
+     */
+    template <typename Recipients>
+    Packet sendToAll(TransactionId transactionId, MessageType messageType, const std::string& message,
+                     const Recipients& recipients, MpiTag tag);
+
+    PooledBuffer encode(LamportTime lamportTime, TransactionId transactionId, MessageType messageType, const std::string& message);
 
-    static Packet getPacket(const std::string& encodedMessage, ProcessId source);
+    /**
+     * Decodes a packet without copying - its message refers to the given buffer, which the packet takes over.
+     */
+    static Packet getPacket(PooledBuffer encodedMessage, ProcessId source);
 
     void updateTimestamp(Packet& packet);
 };
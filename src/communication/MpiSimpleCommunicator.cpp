@@ -1,51 +1,52 @@
+#include <array>
 #include "MpiSimpleCommunicator.h"
 #include <iostream>
 
-Packet MpiSimpleCommunicator::send(MessageType messageType, const std::string& message,
-                                   const std::unordered_set<ProcessId>& recipients, MpiTag tag) {
+template <typename Recipients>
+Packet MpiSimpleCommunicator::sendToAll(TransactionId transactionId, MessageType messageType, const std::string& message,
+                                        const Recipients& recipients, MpiTag tag) {
 
-    std::lock_guard<std::recursive_mutex> lock(communicationMutex);
-
-    RawPacket rawPacket {
-            .lamportTime = static_cast<EncodedLamportTime>(++currentLamportTime),
-            .messageType = static_cast<EncodedMessageType>(messageType),
-            .nextPacketLength = static_cast<EncodedNextPacketLength>(message.size()),
-    };
+    RawPacket rawPacket;
+    // Reused between the calls to keep sending free of allocations
+    thread_local std::vector<MPI_Request> requests;
+    requests.clear();
 
-    for (ProcessId recipient : recipients) {
-        MPI_Send(&rawPacket, 1, mpiRawPacketType, recipient, tag, MPI_COMM_WORLD);
-        if (not message.empty()) {
-            MPI_Send(message.c_str(), static_cast<int>(message.size()), MPI_CHAR, recipient, tag, MPI_COMM_WORLD);
+    {
+        // The sends are only posted under the lock, so that a header is never interleaved with the message of another
+        // thread's packet. Waiting for them to complete does not block the other threads.
+        std::lock_guard<std::mutex> lock(sendMutex);
+        rawPacket = RawPacket {
+                .lamportTime = static_cast<EncodedLamportTime>(lamportClock.tick()),
+                .transactionId = static_cast<EncodedTransactionId>(transactionId),
+                .messageType = static_cast<EncodedMessageType>(messageType),
+                .nextPacketLength = static_cast<EncodedNextPacketLength>(message.size()),
+        };
+        for (ProcessId recipient : recipients) {
+            MPI_Isend(&rawPacket, 1, mpiRawPacketType, recipient, tag, MPI_COMM_WORLD, &requests.emplace_back());
+            if (not message.empty()) {
+                MPI_Isend(message.c_str(), static_cast<int>(message.size()), MPI_CHAR, recipient, tag, MPI_COMM_WORLD,
+                          &requests.emplace_back());
+            }
         }
     }
+    waitForAll(requests);
+    counters.recordSent(recipients.size(), sizeof(RawPacket) + message.size());
 
-    Packet packet {
-            .lamportTime = rawPacket.lamportTime,
-            .source = myProcessId,
-            .messageType = messageType,
-            .message = message
-    };
+    return toPacket(rawPacket, myProcessId, bufferPool.copyOf(message));
+}
 
-    return packet;
+Packet MpiSimpleCommunicator::send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                                   const RankSet& recipients, MpiTag tag) {
+    return sendToAll(transactionId, messageType, message, recipients, tag);
 }
 
-Packet MpiSimpleCommunicator::receive(MpiTag tag) {
-    MPI_Status status;
-    RawPacket rawPacket;
-    MPI_Recv(&rawPacket, 1, mpiRawPacketType, MPI_ANY_SOURCE, tag, MPI_COMM_WORLD, &status);
-    ProcessId source = status.MPI_SOURCE;
+Packet MpiSimpleCommunicator::send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                                   ProcessId recipient, MpiTag tag) {
+    return sendToAll(transactionId, messageType, message, std::array<ProcessId, 1> {recipient}, tag);
+}
 
-    std::string message;
-    uint32_t messageLength = rawPacket.nextPacketLength;
-    if (messageLength > 0) {
-        message.resize(messageLength);
-        MPI_Recv(message.data(), messageLength, MPI_CHAR, source, tag, MPI_COMM_WORLD, &status);
-    }
-    {
-        std::lock_guard<std::recursive_mutex> lock(communicationMutex);
-        currentLamportTime = std::max(rawPacket.lamportTime, currentLamportTime) + 1;
-    }
-    return toPacket(rawPacket, source, message);
+Packet MpiSimpleCommunicator::receive(MpiTag tag) {
+    return receive(-1, tag).value();
 }
 
 Packet MpiSimpleCommunicator::receive() {
@@ -53,52 +54,32 @@ Packet MpiSimpleCommunicator::receive() {
 }
 
 std::optional<Packet> MpiSimpleCommunicator::receive(long timeoutMillis, MpiTag tag) {
-    using namespace std::chrono;
     MPI_Status status;
-    int hasReceivedData;
     RawPacket rawPacket;
-    auto timeStarted = system_clock::now();
+    auto deadline = deadlineAfter(timeoutMillis);
 
     {
         MPI_Request request;
         MPI_Irecv(&rawPacket, 1, mpiRawPacketType, MPI_ANY_SOURCE, tag, MPI_COMM_WORLD, &request);
-
-        do {
-            MPI_Test(&request, &hasReceivedData, &status);
-        } while (not hasReceivedData and duration_cast<milliseconds>(system_clock::now() - timeStarted).count() < timeoutMillis);
-        if (not hasReceivedData) {
-            MPI_Cancel(&request);
-            MPI_Request_free(&request);
+        if (not waitForRequest(request, status, deadline)) {
             return std::nullopt;
         }
     }
 
     ProcessId source = status.MPI_SOURCE;
-    std::string message;
     uint32_t messageLength = rawPacket.nextPacketLength;
-    message.resize(messageLength);
+    PooledBuffer message = bufferPool.acquire(messageLength);
     if (messageLength > 0) {
-        {
-            MPI_Request request;
-            MPI_Irecv(message.data(), messageLength, MPI_CHAR, source, tag, MPI_COMM_WORLD, &request);
-
-            do {
-                MPI_Test(&request, &hasReceivedData, &status);
-            } while (not hasReceivedData and
-                     duration_cast<milliseconds>(system_clock::now() - timeStarted).count() < timeoutMillis);
-            if (not hasReceivedData) {
-                MPI_Cancel(&request);
-                MPI_Request_free(&request);
-                return std::nullopt;
-            }
+        MPI_Request request;
+        MPI_Irecv(message.data(), messageLength, MPI_CHAR, source, tag, MPI_COMM_WORLD, &request);
+        if (not waitForRequest(request, status, deadline)) {
+            return std::nullopt;
         }
     }
 
-    {
-        std::lock_guard<std::recursive_mutex> lock(communicationMutex);
-        currentLamportTime = std::max(rawPacket.lamportTime, currentLamportTime) + 1;
-    }
-    return toPacket(rawPacket, source, message);
+    lamportClock.merge(rawPacket.lamportTime);
+    counters.recordReceived(sizeof(RawPacket) + messageLength);
+    return toPacket(rawPacket, source, std::move(message));
 }
 
 std::optional<Packet> MpiSimpleCommunicator::receive(long timeoutMillis) {
@@ -110,18 +91,61 @@ MpiTag MpiSimpleCommunicator::getDefaultTag() const {
     return MPI_DEFAULT_TAG;
 }
 
-MpiSimpleCommunicator::MpiSimpleCommunicator(int argc, char** argv) {
+bool MpiSimpleCommunicator::waitForRequest(MPI_Request& request, MPI_Status& status,
+                                           std::chrono::steady_clock::time_point deadline) {
+    Backoff backoff(waitStrategy);
+    bool completed = backoff.pollUntil([&] {
+        int hasReceivedData;
+        MPI_Test(&request, &hasReceivedData, &status);
+        return hasReceivedData != 0;
+    }, deadline);
+    if (not completed) {
+        MPI_Cancel(&request);
+        MPI_Request_free(&request);
+    }
+    return completed;
+}
+
+bool MpiSimpleCommunicator::probeUntil(MpiTag tag, MPI_Status& status, std::chrono::steady_clock::time_point deadline) {
+    Backoff backoff(waitStrategy);
+    return backoff.pollUntil([&] {
+        int hasReceivedData;
+        MPI_Iprobe(MPI_ANY_SOURCE, tag, MPI_COMM_WORLD, &hasReceivedData, &status);
+        return hasReceivedData != 0;
+    }, deadline);
+}
+
+void MpiSimpleCommunicator::waitForAll(std::vector<MPI_Request>& requests) {
+    Backoff backoff(waitStrategy);
+    backoff.pollUntil([&] {
+        int completed;
+        MPI_Testall(static_cast<int>(requests.size()), requests.data(), &completed, MPI_STATUSES_IGNORE);
+        return completed != 0;
+    }, std::chrono::steady_clock::time_point::max());
+}
+
+std::chrono::steady_clock::time_point MpiSimpleCommunicator::deadlineAfter(long timeoutMillis) {
+    using namespace std::chrono;
+    if (timeoutMillis < 0) {
+        return steady_clock::time_point::max();
+    }
+    return steady_clock::now() + milliseconds(timeoutMillis);
+}
+
+MpiSimpleCommunicator::MpiSimpleCommunicator(int argc, char** argv, WaitStrategy waitStrategy)
+    : waitStrategy(waitStrategy) {
     int provided = 0;
     MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
     /*************** Create a type for a custom 'RawPacket' structure ***************/
-    const int blockLengths[] = {1, 1, 1};
+    const int blockLengths[] = {1, 1, 1, 1};
     const int fields = sizeof(blockLengths) / sizeof(*blockLengths);
-    MPI_Datatype types[] = {MPI_ENCODED_LAMPORT_TIME, MPI_ENCODED_MESSAGE_TYPE, MPI_NEXT_PACKET_LENGTH};
+    MPI_Datatype types[] = {MPI_ENCODED_LAMPORT_TIME, MPI_ENCODED_TRANSACTION_ID, MPI_ENCODED_MESSAGE_TYPE, MPI_NEXT_PACKET_LENGTH};
     MPI_Aint offsets[fields];
 
     offsets[0] = offsetof(RawPacket, lamportTime);
-    offsets[1] = offsetof(RawPacket, messageType);
-    offsets[2] = offsetof(RawPacket, nextPacketLength);
+    offsets[1] = offsetof(RawPacket, transactionId);
+    offsets[2] = offsetof(RawPacket, messageType);
+    offsets[3] = offsetof(RawPacket, nextPacketLength);
 
     MPI_Type_create_struct(fields, blockLengths, offsets, types, &mpiRawPacketType);
     MPI_Type_commit(&mpiRawPacketType);
@@ -141,24 +165,23 @@ MpiSimpleCommunicator::MpiSimpleCommunicator(int argc, char** argv) {
         }
     }
     /**************************************************************************/
-
-    currentLamportTime = 0;
 }
 
-Packet MpiSimpleCommunicator::toPacket(RawPacket rawPacket, ProcessId source, std::string message) {
+Packet MpiSimpleCommunicator::toPacket(RawPacket rawPacket, ProcessId source, PooledBuffer message) {
     return Packet {
             .lamportTime = static_cast<LamportTime>(rawPacket.lamportTime),
             .source = source,
+            .transactionId = static_cast<TransactionId>(rawPacket.transactionId),
             .messageType = static_cast<MessageType>(rawPacket.messageType),
-            .message = std::move(message)
+            .message = message.view(),
+            .buffer = std::move(message)
     };
 }
 
-LamportTime MpiSimpleCommunicator::getCurrentLamportTime() {
-    std::lock_guard<std::recursive_mutex> lock(communicationMutex);
-    return currentLamportTime;
-}
-
 MpiSimpleCommunicator::~MpiSimpleCommunicator() {
     MPI_Finalize();
 }
+
+void MpiSimpleCommunicator::keepUntilFinalized(std::shared_ptr<void> object) {
+    keptUntilFinalized.push_back(std::move(object));
+}
@@ -2,26 +2,33 @@
 #define INC_3PC_MPISIMPLECOMMUNICATOR_H
 
 #include <mpi.h>
+#include <memory>
 #include <mutex>
+#include <vector>
 #include "ITaggedCommunicator.h"
+#include "Backoff.h"
 
 #define MPI_DEFAULT_TAG 0
 
 // The following 'using' and 'define' sections always have to match
 #define MPI_ENCODED_LAMPORT_TIME MPI_UINT64_T
+#define MPI_ENCODED_TRANSACTION_ID MPI_UINT32_T
 #define MPI_ENCODED_MESSAGE_TYPE MPI_UINT8_T
 #define MPI_NEXT_PACKET_LENGTH MPI_UINT32_T
 using EncodedLamportTime = uint64_t;
+using EncodedTransactionId = uint32_t;
 using EncodedMessageType = uint8_t;
 using EncodedNextPacketLength = uint32_t;
 
 struct RawPacket {
     EncodedLamportTime lamportTime;
+    EncodedTransactionId transactionId;
     EncodedMessageType messageType;
     EncodedNextPacketLength nextPacketLength;
 
     inline bool operator==(const RawPacket& other) const {
-        return messageType == other.messageType && nextPacketLength == other.nextPacketLength;
+        return transactionId == other.transactionId && messageType == other.messageType
+               && nextPacketLength == other.nextPacketLength;
     }
 
     inline bool operator<(const RawPacket& other) const {
@@ -34,7 +41,7 @@ namespace std {
     struct hash<RawPacket> {
         inline std::size_t operator()(const RawPacket& packet) const {
             std::size_t hash = 0;
-            hashCombine(hash, packet.messageType, packet.nextPacketLength);
+            hashCombine(hash, packet.transactionId, packet.messageType, packet.nextPacketLength);
             return hash;
         }
     };
@@ -45,7 +52,13 @@ using MpiTag = int;
 class MpiSimpleCommunicator : public ITaggedCommunicator<MpiTag> {
 public:
 
-    Packet send(MessageType messageType, const std::string& message, const std::unordered_set<ProcessId>& recipients, MpiTag tag) override;
+    using ITaggedCommunicator<MpiTag>::send;
+
+    Packet send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                const RankSet& recipients, MpiTag tag) override;
+
+    Packet send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                ProcessId recipient, MpiTag tag) override;
 
     Packet receive(MpiTag tag) override;
 
@@ -57,18 +70,52 @@ public:
 
     MpiTag getDefaultTag() const override;
 
-    LamportTime getCurrentLamportTime() override;
-
-    MpiSimpleCommunicator(int argc, char** argv);
+    MpiSimpleCommunicator(int argc, char** argv, WaitStrategy waitStrategy = WaitStrategy::BACKOFF);
 
     virtual ~MpiSimpleCommunicator();
 
+    /**
+     * Destroys the given object only after MPI is finalized, e.g. the buffers of operations which MPI may still complete.
+     */
+    void keepUntilFinalized(std::shared_ptr<void> object);
+
 protected:
 
-    static Packet toPacket(RawPacket rawPacket, ProcessId source, std::string message);
+    /**
+     * Sends the packet to every recipient in the given range of process ids, which avoids building a set for a single one.
+     */
+    template <typename Recipients>
+    Packet sendToAll(TransactionId transactionId, MessageType messageType, const std::string& message,
+                     const Recipients& recipients, MpiTag tag);
+
+    static Packet toPacket(RawPacket rawPacket, ProcessId source, PooledBuffer message);
+
+    /**
+     * Polls the given MPI request until it completes or the deadline passes, parking the thread in between
+     * according to the wait strategy. Cancels and frees the request if the deadline passes.
+     * @return Whether the request completed
+     */
+    bool waitForRequest(MPI_Request& request, MPI_Status& status, std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * Non-blocking equivalent of MPI_Probe that parks the thread between probes instead of spinning.
+     * @return Whether a matching message arrived before the deadline
+     */
+    bool probeUntil(MpiTag tag, MPI_Status& status, std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * Waits until all the given requests complete, parking the thread in between polls according to the wait strategy.
+     */
+    void waitForAll(std::vector<MPI_Request>& requests);
+
+    static std::chrono::steady_clock::time_point deadlineAfter(long timeoutMillis);
 
     MPI_Datatype mpiRawPacketType;
-    std::recursive_mutex communicationMutex;
+    /** Keeps the header and the message of a packet adjacent in the stream to every recipient */
+    std::mutex sendMutex;
+    WaitStrategy waitStrategy;
+    /** Destroyed after the destructor has finalized MPI */
+    std::vector<std::shared_ptr<void>> keptUntilFinalized;
 };
 
 #endif //INC_3PC_MPISIMPLECOMMUNICATOR_H
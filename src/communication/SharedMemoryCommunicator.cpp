@@ -0,0 +1,348 @@
+#include <array>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <signal.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "SharedMemoryCommunicator.h"
+
+namespace {
+    constexpr unsigned SPIN_ATTEMPTS = 64;
+    constexpr unsigned YIELD_ATTEMPTS = 16;
+
+    std::size_t alignToCacheLine(std::size_t size) {
+        return (size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    }
+
+    void futexWait(std::atomic<uint32_t>& word, uint32_t expectedValue, const timespec* timeout) {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expectedValue, timeout, nullptr, 0);
+    }
+
+    void futexWakeAll(std::atomic<uint32_t>& word) {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    }
+}
+
+SharedMemoryCommunicator::SharedMemoryCommunicator(WaitStrategy waitStrategy) : waitStrategy(waitStrategy) {
+    std::string rank = getEnvironment({"OMPI_COMM_WORLD_RANK", "PMIX_RANK", "PMI_RANK"});
+    std::string size = getEnvironment({"OMPI_COMM_WORLD_SIZE", "PMI_SIZE"});
+    if (rank.empty() or size.empty()) {
+        throw std::runtime_error("The shared memory transport has to be started by mpirun or another PMI launcher");
+    }
+    myProcessId = std::stoi(rank);
+    numberOfProcesses = std::stoi(size);
+    for (ProcessId id = 0; id < numberOfProcesses; ++id) {
+        if (id != myProcessId) {
+            otherProcesses.insert(id);
+        }
+    }
+    std::string job = getEnvironment({"PMIX_NAMESPACE", "OMPI_MCA_ess_base_jobid"});
+    segmentName = "/3PC-" + (job.empty() ? std::to_string(getppid()) : job);
+    attach();
+}
+
+SharedMemoryCommunicator::~SharedMemoryCommunicator() {
+    for (std::size_t tag = 0; tag < TAG_COUNT; ++tag) {
+        getMailbox(myProcessId, static_cast<SharedMemoryTag>(tag)).alive.store(false);
+    }
+    munmap(segment, getSegmentSize());
+}
+
+void SharedMemoryCommunicator::attach() {
+    const std::size_t segmentSize = getSegmentSize();
+    int descriptor;
+    if (myProcessId == COORDINATOR_ID) {
+        descriptor = shm_open(segmentName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (descriptor < 0 and errno == EEXIST) {
+            // Left behind by a crashed run of the same job
+            shm_unlink(segmentName.c_str());
+            descriptor = shm_open(segmentName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        }
+        if (descriptor < 0 or ftruncate(descriptor, static_cast<off_t>(segmentSize)) != 0) {
+            throw std::runtime_error("Could not create the shared memory segment " + segmentName);
+        }
+    } else {
+        Backoff backoff(waitStrategy);
+        struct stat segmentStatus {};
+        while ((descriptor = shm_open(segmentName.c_str(), O_RDWR, 0600)) < 0
+               or fstat(descriptor, &segmentStatus) != 0 or static_cast<std::size_t>(segmentStatus.st_size) < segmentSize) {
+            if (descriptor >= 0) {
+                close(descriptor);
+            }
+            backoff.pause();
+        }
+    }
+    void* mapping = mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    close(descriptor);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Could not map the shared memory segment " + segmentName);
+    }
+    segment = static_cast<char*>(mapping);
+    auto* header = reinterpret_cast<SegmentHeader*>(segment);
+
+    if (myProcessId == COORDINATOR_ID) {
+        new (header) SegmentHeader {};
+        header->numberOfProcesses = static_cast<uint32_t>(numberOfProcesses);
+        for (ProcessId recipient = 0; recipient < numberOfProcesses; ++recipient) {
+            for (std::size_t tag = 0; tag < TAG_COUNT; ++tag) {
+                new (&getMailbox(recipient, static_cast<SharedMemoryTag>(tag))) Mailbox {};
+                getMailbox(recipient, static_cast<SharedMemoryTag>(tag)).alive.store(true);
+                for (ProcessId sender = 0; sender < numberOfProcesses; ++sender) {
+                    new (&getRing(sender, recipient, static_cast<SharedMemoryTag>(tag))) Ring();
+                }
+            }
+        }
+        header->initialized.store(1, std::memory_order_release);
+    } else {
+        Backoff backoff(waitStrategy);
+        while (header->initialized.load(std::memory_order_acquire) == 0) {
+            backoff.pause();
+        }
+    }
+    for (std::size_t tag = 0; tag < TAG_COUNT; ++tag) {
+        getMailbox(myProcessId, static_cast<SharedMemoryTag>(tag)).pid.store(getpid());
+    }
+
+    header->attached.fetch_add(1);
+    Backoff backoff(waitStrategy);
+    while (header->attached.load() < static_cast<uint32_t>(numberOfProcesses)) {
+        backoff.pause();
+    }
+    if (myProcessId == COORDINATOR_ID) {
+        // Everybody has mapped the segment, so it can lose its name now and is freed with the last mapping, even if
+        // processes crash
+        shm_unlink(segmentName.c_str());
+    }
+}
+
+std::size_t SharedMemoryCommunicator::getSegmentSize() const {
+    const auto processes = static_cast<std::size_t>(numberOfProcesses);
+    return alignToCacheLine(sizeof(SegmentHeader)) + processes * TAG_COUNT * sizeof(Mailbox)
+           + processes * processes * TAG_COUNT * sizeof(Ring);
+}
+
+SharedMemoryCommunicator::Mailbox& SharedMemoryCommunicator::getMailbox(ProcessId recipient, SharedMemoryTag tag) {
+    const std::size_t index = static_cast<std::size_t>(recipient) * TAG_COUNT + static_cast<std::size_t>(tag);
+    return reinterpret_cast<Mailbox*>(segment + alignToCacheLine(sizeof(SegmentHeader)))[index];
+}
+
+SharedMemoryCommunicator::Ring& SharedMemoryCommunicator::getRing(ProcessId sender, ProcessId recipient, SharedMemoryTag tag) {
+    const auto processes = static_cast<std::size_t>(numberOfProcesses);
+    const std::size_t ringsOffset = alignToCacheLine(sizeof(SegmentHeader)) + processes * TAG_COUNT * sizeof(Mailbox);
+    const std::size_t index = (static_cast<std::size_t>(recipient) * TAG_COUNT + static_cast<std::size_t>(tag)) * processes
+                              + static_cast<std::size_t>(sender);
+    return reinterpret_cast<Ring*>(segment + ringsOffset)[index];
+}
+
+bool SharedMemoryCommunicator::isAlive(const Mailbox& mailbox) {
+    // A process which was killed never clears its flag, but a signal to it fails once the launcher reaped it
+    return mailbox.alive.load(std::memory_order_relaxed) and (kill(mailbox.pid.load(std::memory_order_relaxed), 0) == 0 or errno != ESRCH);
+}
+
+Packet SharedMemoryCommunicator::send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                                      const RankSet& recipients, SharedMemoryTag tag) {
+    return sendToAll(transactionId, messageType, message, recipients, tag);
+}
+
+Packet SharedMemoryCommunicator::send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                                      ProcessId recipient, SharedMemoryTag tag) {
+    return sendToAll(transactionId, messageType, message, std::array<ProcessId, 1> {recipient}, tag);
+}
+
+template <typename Recipients>
+Packet SharedMemoryCommunicator::sendToAll(TransactionId transactionId, MessageType messageType, const std::string& message,
+                                           const Recipients& recipients, SharedMemoryTag tag) {
+    if (message.size() > SHARED_MEMORY_MESSAGE_SIZE) {
+        throw std::invalid_argument("Message '" + message + "' is too long for the shared memory transport");
+    }
+    const LamportTime lamportTime = lamportClock.tick();
+    auto fill = [&](SharedMemorySlot& slot) {
+        slot.lamportTime = static_cast<uint64_t>(lamportTime);
+        slot.transactionId = static_cast<uint32_t>(transactionId);
+        slot.messageType = static_cast<uint8_t>(messageType);
+        slot.messageLength = static_cast<uint16_t>(message.size());
+        message.copy(slot.message, message.size());
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(sendMutexes[static_cast<std::size_t>(tag)]);
+        for (ProcessId recipient : recipients) {
+            Mailbox& mailbox = getMailbox(recipient, tag);
+            Ring& ring = getRing(myProcessId, recipient, tag);
+            if (not ring.tryPush(fill)) {
+                // A full ring is drained as soon as its recipient catches up, unless it is gone or stalled
+                const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(SHARED_MEMORY_SEND_TIMEOUT);
+                bool pushed = false;
+                while (not pushed and isAlive(mailbox) and std::chrono::steady_clock::now() < deadline) {
+                    std::this_thread::yield();
+                    drainToBacklog(tag);
+                    pushed = ring.tryPush(fill);
+                }
+                if (not pushed) {
+                    counters.recordDropped();
+                    continue;
+                }
+            }
+            mailbox.sequence.fetch_add(1, std::memory_order_seq_cst);
+            if (mailbox.sleepers.load(std::memory_order_seq_cst) > 0) {
+                futexWakeAll(mailbox.sequence);
+            }
+            counters.recordSent(1, message.size());
+        }
+    }
+
+    PooledBuffer sentMessage = bufferPool.copyOf(message);
+    return Packet {
+            .lamportTime = lamportTime,
+            .source = myProcessId,
+            .transactionId = transactionId,
+            .messageType = messageType,
+            .message = sentMessage.view(),
+            .buffer = std::move(sentMessage)
+    };
+}
+
+Packet SharedMemoryCommunicator::receive(SharedMemoryTag tag) {
+    return receive(-1, tag).value();
+}
+
+Packet SharedMemoryCommunicator::receive() {
+    return receiveAny(-1).value();
+}
+
+std::optional<Packet> SharedMemoryCommunicator::receive(long timeoutMillis, SharedMemoryTag tag) {
+    using namespace std::chrono;
+    const auto deadline = timeoutMillis < 0 ? steady_clock::time_point::max() : steady_clock::now() + milliseconds(timeoutMillis);
+    Mailbox& mailbox = getMailbox(myProcessId, tag);
+    unsigned attempts = 0;
+    while (true) {
+        // Read before checking the rings, so that a packet pushed after the check makes the futex wait return immediately
+        const uint32_t sequence = mailbox.sequence.load(std::memory_order_seq_cst);
+        auto packet = tryReceive(tag);
+        if (packet.has_value()) {
+            return packet;
+        }
+        const auto now = steady_clock::now();
+        if (now >= deadline) {
+            return std::nullopt;
+        }
+        if (waitStrategy == WaitStrategy::BUSY_POLL or attempts < SPIN_ATTEMPTS) {
+            ++attempts;
+            continue;
+        }
+        if (attempts < SPIN_ATTEMPTS + YIELD_ATTEMPTS) {
+            ++attempts;
+            std::this_thread::yield();
+            continue;
+        }
+        mailbox.sleepers.fetch_add(1, std::memory_order_seq_cst);
+        if (deadline == steady_clock::time_point::max()) {
+            futexWait(mailbox.sequence, sequence, nullptr);
+        } else {
+            const auto remaining = duration_cast<nanoseconds>(deadline - now).count();
+            const timespec timeout {static_cast<time_t>(remaining / 1000000000), static_cast<long>(remaining % 1000000000)};
+            futexWait(mailbox.sequence, sequence, &timeout);
+        }
+        mailbox.sleepers.fetch_sub(1, std::memory_order_seq_cst);
+    }
+}
+
+std::optional<Packet> SharedMemoryCommunicator::receive(long timeoutMillis) {
+    return receiveAny(timeoutMillis);
+}
+
+SharedMemoryTag SharedMemoryCommunicator::getDefaultTag() const {
+    return SharedMemoryTag::DEFAULT;
+}
+
+std::size_t SharedMemoryCommunicator::getMaxMessageSize() const {
+    return SHARED_MEMORY_MESSAGE_SIZE;
+}
+
+std::optional<Packet> SharedMemoryCommunicator::tryReceive(SharedMemoryTag tag) {
+    const auto tagIndex = static_cast<std::size_t>(tag);
+    std::lock_guard<std::mutex> lock(receiveMutexes[tagIndex]);
+    if (not backlogs[tagIndex].empty()) {
+        Packet packet = std::move(backlogs[tagIndex].front());
+        backlogs[tagIndex].pop_front();
+        return packet;
+    }
+    return popFromRings(tag);
+}
+
+void SharedMemoryCommunicator::drainToBacklog(SharedMemoryTag tag) {
+    const auto tagIndex = static_cast<std::size_t>(tag);
+    {
+        std::lock_guard<std::mutex> lock(receiveMutexes[tagIndex]);
+        const std::size_t previousSize = backlogs[tagIndex].size();
+        while (auto packet = popFromRings(tag)) {
+            backlogs[tagIndex].push_back(std::move(packet.value()));
+        }
+        if (backlogs[tagIndex].size() == previousSize) {
+            return;
+        }
+    }
+    // Receivers of this process may sleep until the next push, which these packets no longer wait for
+    Mailbox& mailbox = getMailbox(myProcessId, tag);
+    mailbox.sequence.fetch_add(1, std::memory_order_seq_cst);
+    if (mailbox.sleepers.load(std::memory_order_seq_cst) > 0) {
+        futexWakeAll(mailbox.sequence);
+    }
+}
+
+std::optional<Packet> SharedMemoryCommunicator::popFromRings(SharedMemoryTag tag) {
+    const auto tagIndex = static_cast<std::size_t>(tag);
+    for (ProcessId i = 0; i < numberOfProcesses; ++i) {
+        ProcessId sender = (nextSender[tagIndex] + i) % numberOfProcesses;
+        std::optional<Packet> packet;
+        getRing(sender, myProcessId, tag).tryPop([&](const SharedMemorySlot& slot) {
+            PooledBuffer message = bufferPool.copyOf({slot.message, slot.messageLength});
+            lamportClock.merge(static_cast<LamportTime>(slot.lamportTime));
+            packet = Packet {
+                    .lamportTime = static_cast<LamportTime>(slot.lamportTime),
+                    .source = sender,
+                    .transactionId = static_cast<TransactionId>(slot.transactionId),
+                    .messageType = static_cast<MessageType>(slot.messageType),
+                    .message = message.view(),
+                    .buffer = std::move(message)
+            };
+        });
+        if (packet.has_value()) {
+            nextSender[tagIndex] = (sender + 1) % numberOfProcesses;
+            counters.recordReceived(packet->message.size());
+            return packet;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<Packet> SharedMemoryCommunicator::receiveAny(long timeoutMillis) {
+    using namespace std::chrono;
+    const auto deadline = timeoutMillis < 0 ? steady_clock::time_point::max() : steady_clock::now() + milliseconds(timeoutMillis);
+    std::optional<Packet> packet;
+    Backoff backoff(waitStrategy);
+    backoff.pollUntil([&] {
+        for (std::size_t tag = 0; tag < TAG_COUNT and not packet.has_value(); ++tag) {
+            packet = tryReceive(static_cast<SharedMemoryTag>(tag));
+        }
+        return packet.has_value();
+    }, deadline);
+    return packet;
+}
+
+std::string SharedMemoryCommunicator::getEnvironment(std::initializer_list<const char*> names) {
+    for (const char* name : names) {
+        if (const char* value = std::getenv(name)) {
+            return value;
+        }
+    }
+    return "";
+}
@@ -0,0 +1,147 @@
+#ifndef INC_3PC_SHAREDMEMORYCOMMUNICATOR_H
+#define INC_3PC_SHAREDMEMORYCOMMUNICATOR_H
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <util/SpscRing.h>
+#include "ITaggedCommunicator.h"
+#include "Backoff.h"
+
+#define SHARED_MEMORY_RING_CAPACITY 64
+#define SHARED_MEMORY_MESSAGE_SIZE 48
+/** Milliseconds a sender waits for a full ring to be drained before the message is dropped */
+#define SHARED_MEMORY_SEND_TIMEOUT 1000
+
+enum class SharedMemoryTag : unsigned char {
+    DEFAULT, CRASH, HEARTBEAT
+};
+
+/**
+ * Packet as stored in a ring of the shared memory segment. Messages are limited to SHARED_MEMORY_MESSAGE_SIZE bytes.
+ */
+struct SharedMemorySlot {
+    uint64_t lamportTime;
+    uint32_t transactionId;
+    uint8_t messageType;
+    uint16_t messageLength;
+    char message[SHARED_MEMORY_MESSAGE_SIZE];
+};
+
+/**
+ * ITaggedCommunicator for processes running on a single host. The processes share a POSIX shared memory segment
+ * holding a lock-free single-producer single-consumer ring for every (sender, recipient, tag) triple. A process
+ * waiting for packets sleeps on a futex of its own, which senders only wake if somebody is actually sleeping.
+ *
+ * The processes are started by mpirun (or another PMIx launcher), but do not use MPI: the rank, the number of processes
+ * and the name of the segment are taken from the environment the launcher sets up.
+ *
+ * A sender waiting for a full ring takes the packets waiting for it off its own rings meanwhile, so that two processes
+ * sending to each other cannot block each other. A message whose ring stays full for SHARED_MEMORY_SEND_TIMEOUT, or
+ * whose recipient is gone, is dropped and counted, as it would be lost on a network.
+ */
+class SharedMemoryCommunicator : public ITaggedCommunicator<SharedMemoryTag> {
+public:
+
+    using ITaggedCommunicator<SharedMemoryTag>::send;
+
+    explicit SharedMemoryCommunicator(WaitStrategy waitStrategy = WaitStrategy::BACKOFF);
+
+    virtual ~SharedMemoryCommunicator();
+
+    Packet send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                const RankSet& recipients, SharedMemoryTag tag) override;
+
+    Packet send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                ProcessId recipient, SharedMemoryTag tag) override;
+
+    Packet receive(SharedMemoryTag tag) override;
+
+    Packet receive() override;
+
+    std::optional<Packet> receive(long timeoutMillis, SharedMemoryTag tag) override;
+
+    std::optional<Packet> receive(long timeoutMillis) override;
+
+    SharedMemoryTag getDefaultTag() const override;
+
+    std::size_t getMaxMessageSize() const override;
+
+private:
+
+    static constexpr std::size_t TAG_COUNT = 3;
+
+    using Ring = SpscRing<SharedMemorySlot, SHARED_MEMORY_RING_CAPACITY>;
+
+    struct SegmentHeader {
+        std::atomic<uint32_t> initialized;
+        std::atomic<uint32_t> attached;
+        uint32_t numberOfProcesses;
+    };
+
+    /** Wakeup state of one (recipient, tag) pair */
+    struct alignas(CACHE_LINE_SIZE) Mailbox {
+        /** Futex word, incremented after every push to any of the recipient's rings of the tag */
+        std::atomic<uint32_t> sequence;
+        std::atomic<uint32_t> sleepers;
+        std::atomic<bool> alive;
+        /** Of the recipient, which tells a sender whether a full ring will ever be drained even if it was killed */
+        std::atomic<int32_t> pid;
+    };
+
+    /**
+     * The first process creates and initializes the segment, the others map it once it is initialized. Every process
+     * then waits for all the others, so that no packet is sent to a process which has not attached yet.
+     */
+    void attach();
+
+    std::size_t getSegmentSize() const;
+
+    Mailbox& getMailbox(ProcessId recipient, SharedMemoryTag tag);
+
+    Ring& getRing(ProcessId sender, ProcessId recipient, SharedMemoryTag tag);
+
+    /**
+     * @return Whether the recipient of the mailbox neither finished nor died
+     */
+    static bool isAlive(const Mailbox& mailbox);
+
+    template <typename Recipients>
+    Packet sendToAll(TransactionId transactionId, MessageType messageType, const std::string& message,
+                     const Recipients& recipients, SharedMemoryTag tag);
+
+    std::optional<Packet> tryReceive(SharedMemoryTag tag);
+
+    /**
+     * Takes the next packet of the tag off the rings, starting with the sender after the previous one. The caller holds
+     * the receive mutex of the tag.
+     */
+    std::optional<Packet> popFromRings(SharedMemoryTag tag);
+
+    /**
+     * Moves the packets of the tag waiting in the rings to the backlog and wakes up receivers of the tag if there were any.
+     */
+    void drainToBacklog(SharedMemoryTag tag);
+
+    /**
+     * A thread can only sleep on a single futex, so waiting for a packet of any tag falls back to polling.
+     */
+    std::optional<Packet> receiveAny(long timeoutMillis);
+
+    static std::string getEnvironment(std::initializer_list<const char*> names);
+
+    std::string segmentName;
+    char* segment = nullptr;
+    WaitStrategy waitStrategy;
+    /** Serialize the threads of this process producing into (or consuming from) the rings of a tag */
+    std::mutex sendMutexes[TAG_COUNT];
+    std::mutex receiveMutexes[TAG_COUNT];
+    /** Sender whose ring is checked first by the next receive, so that no sender is starved */
+    ProcessId nextSender[TAG_COUNT] = {};
+    /** Packets taken off the rings while a send waited for a full ring, received before the rings */
+    std::deque<Packet> backlogs[TAG_COUNT];
+};
+
+#endif //INC_3PC_SHAREDMEMORYCOMMUNICATOR_H
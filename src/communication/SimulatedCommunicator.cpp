@@ -0,0 +1,93 @@
+#include <array>
+#include "SimulatedCommunicator.h"
+
+SimulatedCommunicator::SimulatedCommunicator(std::shared_ptr<SimulatedNetwork> network, ProcessId processId)
+    : network(std::move(network)) {
+    myProcessId = processId;
+    numberOfProcesses = this->network->getNumberOfProcesses();
+    for (ProcessId id = 0; id < numberOfProcesses; ++id) {
+        if (id != myProcessId) {
+            otherProcesses.insert(id);
+        }
+    }
+}
+
+std::vector<std::shared_ptr<SimulatedCommunicator>> SimulatedCommunicator::createCluster(const std::shared_ptr<SimulatedNetwork>& network) {
+    std::vector<std::shared_ptr<SimulatedCommunicator>> communicators;
+    for (ProcessId id = 0; id < network->getNumberOfProcesses(); ++id) {
+        communicators.push_back(std::make_shared<SimulatedCommunicator>(network, id));
+    }
+    return communicators;
+}
+
+Packet SimulatedCommunicator::send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                                   const RankSet& recipients, SimulatedTag tag) {
+    return sendToAll(transactionId, messageType, message, recipients, tag);
+}
+
+Packet SimulatedCommunicator::send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                                   ProcessId recipient, SimulatedTag tag) {
+    return sendToAll(transactionId, messageType, message, std::array<ProcessId, 1> {recipient}, tag);
+}
+
+template <typename Recipients>
+Packet SimulatedCommunicator::sendToAll(TransactionId transactionId, MessageType messageType, const std::string& message,
+                                        const Recipients& recipients, SimulatedTag tag) {
+    PooledBuffer sentMessage = bufferPool.copyOf(message);
+    Packet packet {
+            .lamportTime = lamportClock.tick(),
+            .source = myProcessId,
+            .transactionId = transactionId,
+            .messageType = messageType,
+            .message = sentMessage.view(),
+            .buffer = std::move(sentMessage)
+    };
+    network->send(packet, recipients, tag);
+    counters.recordSent(recipients.size(), message.size());
+    return packet;
+}
+
+Packet SimulatedCommunicator::receive(SimulatedTag tag) {
+    return receive(-1, std::optional<SimulatedTag>(tag)).value();
+}
+
+Packet SimulatedCommunicator::receive() {
+    return receive(-1, std::optional<SimulatedTag>()).value();
+}
+
+std::optional<Packet> SimulatedCommunicator::receive(long timeoutMillis, SimulatedTag tag) {
+    return receive(timeoutMillis, std::optional<SimulatedTag>(tag));
+}
+
+std::optional<Packet> SimulatedCommunicator::receive(long timeoutMillis) {
+    return receive(timeoutMillis, std::optional<SimulatedTag>());
+}
+
+SimulatedTag SimulatedCommunicator::getDefaultTag() const {
+    return SimulatedTag::DEFAULT;
+}
+
+std::chrono::steady_clock::time_point SimulatedCommunicator::now() {
+    return network->now();
+}
+
+void SimulatedCommunicator::sleepFor(std::chrono::milliseconds duration) {
+    network->sleepFor(myProcessId, duration);
+}
+
+void SimulatedCommunicator::attach() {
+    network->attach(myProcessId);
+}
+
+void SimulatedCommunicator::detach() {
+    network->detach();
+}
+
+std::optional<Packet> SimulatedCommunicator::receive(long timeoutMillis, std::optional<SimulatedTag> tag) {
+    auto packet = network->receive(myProcessId, timeoutMillis, tag);
+    if (packet.has_value()) {
+        lamportClock.merge(packet->lamportTime);
+        counters.recordReceived(packet->message.size());
+    }
+    return packet;
+}
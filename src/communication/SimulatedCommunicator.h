@@ -0,0 +1,59 @@
+#ifndef INC_3PC_SIMULATEDCOMMUNICATOR_H
+#define INC_3PC_SIMULATEDCOMMUNICATOR_H
+
+#include "SimulatedNetwork.h"
+
+/**
+ * ITaggedCommunicator of one process of a SimulatedNetwork. Its clock and sleeps run in the virtual time of the network.
+ */
+class SimulatedCommunicator : public ITaggedCommunicator<SimulatedTag> {
+public:
+
+    using ITaggedCommunicator<SimulatedTag>::send;
+
+    SimulatedCommunicator(std::shared_ptr<SimulatedNetwork> network, ProcessId processId);
+
+    /**
+     * @return A communicator for every process of the network, indexed by process id
+     */
+    static std::vector<std::shared_ptr<SimulatedCommunicator>> createCluster(const std::shared_ptr<SimulatedNetwork>& network);
+
+    Packet send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                const RankSet& recipients, SimulatedTag tag) override;
+
+    Packet send(TransactionId transactionId, MessageType messageType, const std::string& message,
+                ProcessId recipient, SimulatedTag tag) override;
+
+    Packet receive(SimulatedTag tag) override;
+
+    Packet receive() override;
+
+    std::optional<Packet> receive(long timeoutMillis, SimulatedTag tag) override;
+
+    std::optional<Packet> receive(long timeoutMillis) override;
+
+    SimulatedTag getDefaultTag() const override;
+
+    std::chrono::steady_clock::time_point now() override;
+
+    void sleepFor(std::chrono::milliseconds duration) override;
+
+    /**
+     * Makes the calling thread the main thread of this process in the simulation, see SimulatedNetwork::attach.
+     */
+    void attach();
+
+    void detach();
+
+private:
+
+    template <typename Recipients>
+    Packet sendToAll(TransactionId transactionId, MessageType messageType, const std::string& message,
+                     const Recipients& recipients, SimulatedTag tag);
+
+    std::optional<Packet> receive(long timeoutMillis, std::optional<SimulatedTag> tag);
+
+    std::shared_ptr<SimulatedNetwork> network;
+};
+
+#endif //INC_3PC_SIMULATEDCOMMUNICATOR_H
@@ -0,0 +1,246 @@
+#include <stdexcept>
+#include <tuple>
+#include "SimulatedNetwork.h"
+
+SimulatedNetwork::SimulatedNetwork(ProcessId numberOfProcesses, unsigned threadsPerProcess, NetworkConditions conditions,
+                                   unsigned seed)
+    : numberOfProcesses(numberOfProcesses), threadsPerProcess(threadsPerProcess), conditions(conditions), random(seed),
+      processes(static_cast<std::size_t>(numberOfProcesses)) {
+    if (numberOfProcesses <= 0 or threadsPerProcess == 0) {
+        throw std::invalid_argument("A simulated network needs at least one process with at least one thread");
+    }
+    for (auto& process : processes) {
+        process.nextDeliveryTimes.assign(static_cast<std::size_t>(numberOfProcesses), TimePoint {});
+    }
+}
+
+SimulatedNetwork::ActorRegistration::~ActorRegistration() {
+    if (network != nullptr and actor != nullptr) {
+        std::lock_guard<std::mutex> lock(network->mutex);
+        network->leave(*actor);
+    }
+}
+
+void SimulatedNetwork::scheduleCrash(ProcessId processId, std::chrono::milliseconds time) {
+    std::lock_guard<std::mutex> lock(mutex);
+    deliveries.push_back(Delivery {
+            .time = TimePoint {} + time,
+            .sequenceNumber = deliverySequenceNumber++,
+            .recipient = processId,
+            .tag = SimulatedTag::CRASH,
+            .packet = Packet {
+                    .lamportTime = 0,
+                    .source = COORDINATOR_ID,
+                    .transactionId = 0,
+                    .messageType = MessageType::CRASH,
+                    .message = {},
+                    .buffer = {}
+            }
+    });
+    std::push_heap(deliveries.begin(), deliveries.end(), laterDelivery);
+}
+
+void SimulatedNetwork::attach(ProcessId processId) {
+    std::unique_lock<std::mutex> lock(mutex);
+    ++attachedProcesses;
+    getActor(processId, lock);
+}
+
+void SimulatedNetwork::detach() {
+    std::lock_guard<std::mutex> lock(mutex);
+    ActorRegistration& registration = getRegistration();
+    if (registration.network == this and registration.actor != nullptr) {
+        leave(*registration.actor);
+    }
+    registration = ActorRegistration();
+}
+
+void SimulatedNetwork::awaitCompletion() {
+    std::unique_lock<std::mutex> lock(mutex);
+    completed.wait(lock, [&] { return finished; });
+}
+
+std::optional<Packet> SimulatedNetwork::receive(ProcessId processId, long timeoutMillis, std::optional<SimulatedTag> tag) {
+    std::unique_lock<std::mutex> lock(mutex);
+    Actor& actor = getActor(processId, lock);
+    std::optional<TimePoint> deadline;
+    if (timeoutMillis >= 0) {
+        deadline = currentTime + std::chrono::milliseconds(timeoutMillis);
+    }
+    while (true) {
+        auto packet = takePacket(processes[processId], tag);
+        if (packet.has_value() or (deadline.has_value() and currentTime >= deadline.value())) {
+            return packet;
+        }
+        actor.awaitsPacket = true;
+        actor.awaitedTag = tag;
+        wait(actor, deadline, lock);
+    }
+}
+
+void SimulatedNetwork::sleepFor(ProcessId processId, std::chrono::milliseconds duration) {
+    std::unique_lock<std::mutex> lock(mutex);
+    Actor& actor = getActor(processId, lock);
+    wait(actor, currentTime + duration, lock);
+}
+
+SimulatedNetwork::TimePoint SimulatedNetwork::now() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return currentTime;
+}
+
+std::chrono::steady_clock::duration SimulatedNetwork::getElapsedTime() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return currentTime - TimePoint {};
+}
+
+unsigned long SimulatedNetwork::getEventCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return eventCount;
+}
+
+unsigned long SimulatedNetwork::getDeliveredMessageCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return deliveredMessages;
+}
+
+unsigned long SimulatedNetwork::getLostMessageCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lostMessages;
+}
+
+SimulatedNetwork::ActorRegistration& SimulatedNetwork::getRegistration() {
+    thread_local ActorRegistration registration;
+    return registration;
+}
+
+SimulatedNetwork::Actor& SimulatedNetwork::getActor(ProcessId processId, std::unique_lock<std::mutex>& lock) {
+    ActorRegistration& registration = getRegistration();
+    if (registration.network == this and registration.actor != nullptr) {
+        return *registration.actor;
+    }
+    ProcessState& process = processes.at(static_cast<std::size_t>(processId));
+    if (process.started and process.actors.size() < threadsPerProcess) {
+        --missingActors;
+    }
+    actors.push_back(std::make_unique<Actor>());
+    Actor& actor = *actors.back();
+    actor.processId = processId;
+    actor.index = static_cast<unsigned>(process.actors.size());
+    process.actors.push_back(&actor);
+    ++liveActors;
+    registration.network = this;
+    registration.actor = &actor;
+    // The thread may have joined at any point while another actor was running, so it runs in its turn at the current time
+    wait(actor, currentTime, lock);
+    return actor;
+}
+
+void SimulatedNetwork::wait(Actor& actor, std::optional<TimePoint> wakeTime, std::unique_lock<std::mutex>& lock) {
+    if (wakeTime.has_value()) {
+        timeouts.push_back(Timeout {wakeTime.value(), actor.processId, actor.index, actor.generation, &actor});
+        std::push_heap(timeouts.begin(), timeouts.end(), laterTimeout);
+    }
+    if (running == &actor or running == nullptr) {
+        dispatch();
+    }
+    actor.resumed.wait(lock, [&] { return running == &actor; });
+}
+
+void SimulatedNetwork::dispatch() {
+    running = nullptr;
+    if (liveActors == 0) {
+        finished = true;
+        completed.notify_all();
+        return;
+    }
+    if (not allActorsJoined()) {
+        return;
+    }
+    while (true) {
+        while (not timeouts.empty() and (timeouts.front().actor->exited
+                                         or timeouts.front().generation != timeouts.front().actor->generation)) {
+            std::pop_heap(timeouts.begin(), timeouts.end(), laterTimeout);
+            timeouts.pop_back();
+        }
+        if (deliveries.empty() and timeouts.empty()) {
+            throw std::logic_error("The simulation is stuck - every thread waits without a timeout");
+        }
+        ++eventCount;
+        // A packet arriving exactly at the deadline of a receive is still received
+        if (not deliveries.empty() and (timeouts.empty() or deliveries.front().time <= timeouts.front().time)) {
+            std::pop_heap(deliveries.begin(), deliveries.end(), laterDelivery);
+            Delivery delivery = std::move(deliveries.back());
+            deliveries.pop_back();
+            currentTime = std::max(currentTime, delivery.time);
+            ++deliveredMessages;
+            ProcessState& process = processes[delivery.recipient];
+            process.packets[static_cast<std::size_t>(delivery.tag)].push_back(std::move(delivery.packet));
+            for (Actor* actor : process.actors) {
+                if (not actor->exited and actor->awaitsPacket
+                    and (not actor->awaitedTag.has_value() or actor->awaitedTag.value() == delivery.tag)) {
+                    resume(*actor);
+                    return;
+                }
+            }
+            continue;
+        }
+        std::pop_heap(timeouts.begin(), timeouts.end(), laterTimeout);
+        Timeout timeout = timeouts.back();
+        timeouts.pop_back();
+        currentTime = std::max(currentTime, timeout.time);
+        resume(*timeout.actor);
+        return;
+    }
+}
+
+void SimulatedNetwork::resume(Actor& actor) {
+    ++actor.generation;
+    actor.awaitsPacket = false;
+    ProcessState& process = processes[actor.processId];
+    if (not process.started) {
+        process.started = true;
+        if (process.actors.size() < threadsPerProcess) {
+            missingActors += threadsPerProcess - static_cast<unsigned>(process.actors.size());
+        }
+    }
+    running = &actor;
+    actor.resumed.notify_one();
+}
+
+void SimulatedNetwork::leave(Actor& actor) {
+    if (actor.exited) {
+        return;
+    }
+    actor.exited = true;
+    --liveActors;
+    if (running == &actor) {
+        dispatch();
+    }
+}
+
+bool SimulatedNetwork::allActorsJoined() const {
+    return attachedProcesses == static_cast<unsigned>(numberOfProcesses) and missingActors == 0;
+}
+
+std::optional<Packet> SimulatedNetwork::takePacket(ProcessState& process, std::optional<SimulatedTag> tag) {
+    for (std::size_t tagIndex = 0; tagIndex < TAG_COUNT; ++tagIndex) {
+        std::deque<Packet>& packets = process.packets[tagIndex];
+        if ((tag.has_value() and static_cast<std::size_t>(tag.value()) != tagIndex) or packets.empty()) {
+            continue;
+        }
+        Packet packet = std::move(packets.front());
+        packets.pop_front();
+        return packet;
+    }
+    return std::nullopt;
+}
+
+bool SimulatedNetwork::laterDelivery(const Delivery& first, const Delivery& second) {
+    return std::tie(first.time, first.sequenceNumber) > std::tie(second.time, second.sequenceNumber);
+}
+
+bool SimulatedNetwork::laterTimeout(const Timeout& first, const Timeout& second) {
+    return std::tie(first.time, first.processId, first.index, first.generation)
+           > std::tie(second.time, second.processId, second.index, second.generation);
+}
@@ -0,0 +1,267 @@
+#ifndef INC_3PC_SIMULATEDNETWORK_H
+#define INC_3PC_SIMULATEDNETWORK_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <util/Random.h>
+#include "ITaggedCommunicator.h"
+
+enum class SimulatedTag : unsigned char {
+    DEFAULT, CRASH, HEARTBEAT
+};
+
+/**
+ * Behaviour of the links of a SimulatedNetwork. Messages a process sends to itself are always delivered immediately.
+ */
+struct NetworkConditions {
+    std::chrono::milliseconds minLatency {1};
+    std::chrono::milliseconds maxLatency {1};
+    /**
+     * Time a process spends on every message it sends or receives: the copies of a multicast leave the sender one after
+     * another, and a recipient takes in one message after another, in the order they were sent
+     */
+    std::chrono::microseconds messageCost {0};
+    /** Percentage of the messages which are lost */
+    unsigned lossPercent = 0;
+    /** Whether the messages of a sender to a recipient may overtake each other */
+    bool reordering = true;
+};
+
+/**
+ * Deterministic discrete-event simulation of a network connecting processes which are threads of the current process.
+ *
+ * Every thread waiting on the network (an actor) is a real thread, but only one of them runs at a time: an actor
+ * hands over to the next one whenever it waits for a packet or sleeps. Virtual time only advances when every actor
+ * waits, straight to the next delivery or timeout, so idle periods cost nothing. All random decisions come from a single
+ * seeded generator and ties are broken by the process ids, so a simulation can be replayed exactly from its seed.
+ *
+ * Each process has a main thread, which has to call attach() before it does anything else and detach() once it is done,
+ * and further threads of its own, which join on their first wait. The network only advances time once all the threads
+ * of every started process have joined, which is why their number has to be known up front. Threads joining this way
+ * leave it when they exit.
+ */
+class SimulatedNetwork {
+public:
+
+    static constexpr std::size_t TAG_COUNT = 3;
+
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    SimulatedNetwork(ProcessId numberOfProcesses, unsigned threadsPerProcess, NetworkConditions conditions, unsigned seed);
+
+    ProcessId getNumberOfProcesses() const {
+        return numberOfProcesses;
+    }
+
+    /**
+     * Delivers a crash signal to the process at the given virtual time. Must be called before the simulation starts.
+     */
+    void scheduleCrash(ProcessId processId, std::chrono::milliseconds time);
+
+    /**
+     * Makes the calling thread the main thread of the process and waits until the simulation lets it run.
+     */
+    void attach(ProcessId processId);
+
+    /**
+     * Removes the calling thread from the simulation, which goes on without waiting for it.
+     */
+    void detach();
+
+    /**
+     * Blocks until every thread of the simulation has left it.
+     */
+    void awaitCompletion();
+
+    /**
+     * Queues a packet for delivery to each recipient after a random latency, unless it gets lost.
+     */
+    template <typename Recipients>
+    void send(const Packet& packet, const Recipients& recipients, SimulatedTag tag);
+
+    /**
+     * Waits in virtual time for a packet of the given tag (or any tag) addressed to the process.
+     * @param timeoutMillis Negative to wait without a timeout
+     */
+    std::optional<Packet> receive(ProcessId processId, long timeoutMillis, std::optional<SimulatedTag> tag);
+
+    void sleepFor(ProcessId processId, std::chrono::milliseconds duration);
+
+    TimePoint now();
+
+    std::chrono::steady_clock::duration getElapsedTime();
+
+    unsigned long getEventCount();
+
+    unsigned long getDeliveredMessageCount();
+
+    unsigned long getLostMessageCount();
+
+private:
+
+    struct Actor {
+        ProcessId processId;
+        /** Order in which the threads of the process joined, the main thread being the first */
+        unsigned index;
+        std::condition_variable resumed;
+        bool awaitsPacket = false;
+        /** Tag of the awaited packet, any if not set */
+        std::optional<SimulatedTag> awaitedTag;
+        /** Incremented on every wakeup, which invalidates the timeouts of earlier waits */
+        unsigned long generation = 0;
+        bool exited = false;
+    };
+
+    struct Delivery {
+        TimePoint time;
+        unsigned long sequenceNumber;
+        ProcessId recipient;
+        SimulatedTag tag;
+        Packet packet;
+    };
+
+    struct Timeout {
+        TimePoint time;
+        ProcessId processId;
+        unsigned index;
+        unsigned long generation;
+        Actor* actor;
+    };
+
+    struct ProcessState {
+        std::deque<Packet> packets[TAG_COUNT];
+        std::vector<Actor*> actors;
+        /** Whether the main thread has run, after which all the threads of the process have to join before time advances */
+        bool started = false;
+        /** Earliest time the next message of every sender may be delivered at, if messages must not be reordered */
+        std::vector<TimePoint> nextDeliveryTimes;
+        /** Until when the process is busy sending and receiving, if messages have a cost */
+        TimePoint sendingUntil {};
+        TimePoint receivingUntil {};
+    };
+
+    /** Leaves the simulation when a thread which joined it exits */
+    struct ActorRegistration {
+        SimulatedNetwork* network = nullptr;
+        Actor* actor = nullptr;
+
+        ~ActorRegistration();
+    };
+
+    static ActorRegistration& getRegistration();
+
+    /**
+     * @return The actor of the calling thread. A new thread joins the simulation as a thread of the given process and
+     * waits for its turn first.
+     */
+    Actor& getActor(ProcessId processId, std::unique_lock<std::mutex>& lock);
+
+    /**
+     * Hands over to the next actor and waits until the simulation resumes this one.
+     */
+    void wait(Actor& actor, std::optional<TimePoint> wakeTime, std::unique_lock<std::mutex>& lock);
+
+    /**
+     * Advances virtual time to the next event and resumes the actor it concerns. Called whenever the running actor
+     * stops running.
+     */
+    void dispatch();
+
+    void resume(Actor& actor);
+
+    void leave(Actor& actor);
+
+    /**
+     * @return Whether every thread which is going to join has done so, so that the order of events cannot depend on
+     * how the operating system schedules the threads
+     */
+    bool allActorsJoined() const;
+
+    std::optional<Packet> takePacket(ProcessState& process, std::optional<SimulatedTag> tag);
+
+    static bool laterDelivery(const Delivery& first, const Delivery& second);
+
+    static bool laterTimeout(const Timeout& first, const Timeout& second);
+
+    ProcessId numberOfProcesses;
+    unsigned threadsPerProcess;
+    NetworkConditions conditions;
+    Random random;
+    /** Storage of the messages in flight, declared first so that it is destroyed after the packets */
+    BufferPool bufferPool;
+
+    std::mutex mutex;
+    std::condition_variable completed;
+    bool finished = false;
+    TimePoint currentTime {};
+    std::vector<ProcessState> processes;
+    std::vector<std::unique_ptr<Actor>> actors;
+    /** Min-heaps ordered by the time of the events */
+    std::vector<Delivery> deliveries;
+    std::vector<Timeout> timeouts;
+    /** Actor currently running, nullptr while the simulation waits for threads to join */
+    Actor* running = nullptr;
+    unsigned attachedProcesses = 0;
+    /** Threads of the started processes which have not joined yet */
+    unsigned missingActors = 0;
+    unsigned liveActors = 0;
+    unsigned long deliverySequenceNumber = 0;
+    unsigned long eventCount = 0;
+    unsigned long deliveredMessages = 0;
+    unsigned long lostMessages = 0;
+};
+
+template <typename Recipients>
+void SimulatedNetwork::send(const Packet& packet, const Recipients& recipients, SimulatedTag tag) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (ProcessId recipient : recipients) {
+        TimePoint deliveryTime = currentTime;
+        if (recipient != packet.source) {
+            if (conditions.messageCost.count() > 0) {
+                TimePoint& sendingUntil = processes[packet.source].sendingUntil;
+                sendingUntil = std::max(sendingUntil, currentTime) + conditions.messageCost;
+                deliveryTime = sendingUntil;
+            }
+            if (random.randomBetween(0u, 99u) < conditions.lossPercent) {
+                ++lostMessages;
+                continue;
+            }
+            deliveryTime += std::chrono::microseconds(random.randomBetween(
+                    static_cast<long>(std::chrono::microseconds(conditions.minLatency).count()),
+                    static_cast<long>(std::chrono::microseconds(conditions.maxLatency).count())));
+            if (not conditions.reordering) {
+                TimePoint& nextDeliveryTime = processes[recipient].nextDeliveryTimes[packet.source];
+                deliveryTime = std::max(deliveryTime, nextDeliveryTime);
+                nextDeliveryTime = deliveryTime;
+            }
+            if (conditions.messageCost.count() > 0) {
+                TimePoint& receivingUntil = processes[recipient].receivingUntil;
+                receivingUntil = std::max(receivingUntil + conditions.messageCost, deliveryTime);
+                deliveryTime = receivingUntil;
+            }
+        }
+        PooledBuffer message = bufferPool.copyOf(packet.message);
+        deliveries.push_back(Delivery {
+                .time = deliveryTime,
+                .sequenceNumber = deliverySequenceNumber++,
+                .recipient = recipient,
+                .tag = tag,
+                .packet = Packet {
+                        .lamportTime = packet.lamportTime,
+                        .source = packet.source,
+                        .transactionId = packet.transactionId,
+                        .messageType = packet.messageType,
+                        .message = message.view(),
+                        .buffer = std::move(message)
+                }
+        });
+        std::push_heap(deliveries.begin(), deliveries.end(), laterDelivery);
+    }
+}
+
+#endif //INC_3PC_SIMULATEDNETWORK_H
@@ -0,0 +1,47 @@
+#ifndef INC_3PC_LOGRECORD_H
+#define INC_3PC_LOGRECORD_H
+
+#include <algorithm>
+#include <ctime>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <communication/ICommunicator.h>
+#include "ConsoleColor.h"
+
+/**
+ * Protocol state a log entry refers to. Kept structured so that it can be formatted off the logging thread.
+ */
+struct LogContext {
+    State state;
+    TransactionId transactionId;
+    /** Type of the message which was sent or received, if the entry is about one */
+    std::optional<MessageType> messageType = std::nullopt;
+};
+
+/**
+ * Fixed-size log entry. Messages longer than LOG_RECORD_MESSAGE_SIZE are truncated when the entry goes through a ring
+ * of the asynchronous mode, synchronously written entries keep their whole message.
+ */
+struct LogRecord {
+    LamportTime lamportTime;
+    unsigned long sequenceNumber;
+    std::time_t wallTime;
+    bool hasContext;
+    LogContext context;
+    rang::fg color;
+    rang::style style;
+    unsigned short messageLength;
+    char message[LOG_RECORD_MESSAGE_SIZE];
+
+    void setMessage(std::string_view text) {
+        messageLength = static_cast<unsigned short>(std::min(text.size(), sizeof(message)));
+        std::memcpy(message, text.data(), messageLength);
+    }
+
+    std::string_view getMessage() const {
+        return {message, messageLength};
+    }
+};
+
+#endif //INC_3PC_LOGRECORD_H
@@ -1,31 +1,271 @@
 #include <mutex>
 #include <util/Define.h>
+#include <communication/Backoff.h>
 #include <iomanip>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
 #include "Logger.h"
+#include "TraceFormat.h"
+#include "Timeline.h"
 
 std::mutex Logger::mutex;
-std::map<std::thread::id, std::pair<std::string, rang::fg>> Logger::threads;
-unsigned Logger::logMessageCounter = 0;
+std::vector<std::unique_ptr<Logger::ThreadSlot>> Logger::threads;
+std::atomic<unsigned long> Logger::logMessageCounter = 0;
 std::shared_ptr<ICommunicator> Logger::communicator;
+const LamportClock* Logger::lamportClock = nullptr;
+std::atomic<bool> Logger::asynchronous = false;
+bool Logger::consoleOutput = true;
+std::thread Logger::writer;
+std::vector<std::pair<LogRecord, Logger::ThreadSlot*>> Logger::pending;
+unsigned long Logger::nextSequenceNumber = 0;
+FILE* Logger::traceFile = nullptr;
 rang::style backgroundColor = rang::style::reset;
 
-void Logger::init(std::shared_ptr<ICommunicator> communicator) {
+void Logger::init(std::shared_ptr<ICommunicator> communicator, LoggingMode mode, bool consoleOutput) {
     Logger::communicator = std::move(communicator);
+    lamportClock = &Logger::communicator->getLamportClock();
+    Logger::consoleOutput = consoleOutput;
+    if (mode == LoggingMode::ASYNCHRONOUS and not asynchronous.load()) {
+        {
+            // Entries logged so far were written synchronously
+            std::lock_guard<std::mutex> guard(mutex);
+            nextSequenceNumber = logMessageCounter.load();
+            asynchronous = true;
+        }
+        writer = std::thread(writeAsynchronously);
+    }
+}
+
+void Logger::openTrace(const std::string& path) {
+    std::lock_guard<std::mutex> guard(mutex);
+    traceFile = std::fopen(path.c_str(), "wb");
+    if (traceFile == nullptr) {
+        throw std::runtime_error("Could not open the trace file " + path);
+    }
+    std::setvbuf(traceFile, nullptr, _IOFBF, 1 << 20);
+    TraceFileHeader header {};
+    std::memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.rank = static_cast<uint32_t>(communicator->getProcessId());
+    std::fwrite(&header, sizeof(header), 1, traceFile);
+}
+
+void Logger::shutdown() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (asynchronous.load()) {
+        // Entries logged synchronously from now on wait for the lock, so they are written after all pending ones
+        asynchronous = false;
+        // A thread which saw the asynchronous mode right before the switch may still push its entry
+        for (auto& slot : threads) {
+            while (slot->pushing.load()) {
+                std::this_thread::yield();
+            }
+        }
+        drainRings(true);
+        lock.unlock();
+        writer.join();
+        lock.lock();
+    }
+    if (traceFile != nullptr) {
+        std::fclose(traceFile);
+        traceFile = nullptr;
+    }
 }
 
 void Logger::registerThread(std::string threadFriendlyName, rang::fg consoleColor) {
+    if (communicator != nullptr) {
+        Timeline::registerThread(threadFriendlyName, communicator->getProcessId());
+    }
+    if (not hasOutput()) {
+        return;
+    }
+    ThreadSlot& slot = getThreadSlot();
+    std::lock_guard<std::mutex> guard(mutex);
+    slot.name = std::move(threadFriendlyName);
+    slot.color = consoleColor;
+}
+
+void Logger::registerThread(std::string threadFriendlyName, const std::shared_ptr<ICommunicator>& processCommunicator,
+                            rang::fg consoleColor) {
+    Timeline::registerThread(threadFriendlyName, processCommunicator->getProcessId());
+    if (not hasOutput()) {
+        return;
+    }
+    ThreadSlot& slot = getThreadSlot();
     std::lock_guard<std::mutex> guard(mutex);
-    threads[std::this_thread::get_id()] = {std::move(threadFriendlyName), consoleColor};
+    slot.name = std::move(threadFriendlyName);
+    slot.color = consoleColor;
+    slot.processId = processCommunicator->getProcessId();
+    slot.lamportClock = &processCommunicator->getLamportClock();
+}
+
+void Logger::log(std::string_view message, rang::fg color, rang::style style) {
+    log(nullptr, message, color, style);
 }
 
-void Logger::log(const std::string& message, rang::fg color, rang::style style) {
+void Logger::log(const LogContext& context, std::string_view message) {
+    log(&context, message, rang::fg::reset, rang::style::reset);
+}
+
+void Logger::log(const LogContext* context, std::string_view message, rang::fg color, rang::style style) {
+    if (not hasOutput()) {
+        return;
+    }
+    ThreadSlot& slot = getThreadSlot();
+    auto fill = [&](LogRecord& record) {
+        record.lamportTime = (slot.lamportClock != nullptr ? slot.lamportClock : lamportClock)->get();
+        record.sequenceNumber = logMessageCounter.fetch_add(1, std::memory_order_relaxed);
+        record.wallTime = getCurrentTime();
+        record.hasContext = context != nullptr;
+        if (context != nullptr) {
+            record.context = *context;
+        }
+        record.color = color;
+        record.style = style;
+    };
+    // Sequentially consistent along with the mode switch: either shutdown waits for the push or the mode is seen switched
+    slot.pushing.store(true);
+    while (asynchronous.load()) {
+        if (slot.ring.tryPush([&](LogRecord& record) {
+            fill(record);
+            record.setMessage(message);
+        })) {
+            slot.pushing.store(false, std::memory_order_release);
+            return;
+        }
+        // The ring is full - wait for the background thread to catch up instead of losing the entry
+        std::this_thread::yield();
+    }
+    slot.pushing.store(false, std::memory_order_release);
     std::lock_guard<std::mutex> guard(mutex);
-    auto [threadId, threadColor] = threads[std::this_thread::get_id()];
-    ProcessId myProcessId = communicator->getProcessId();
-    std::string formattedLamportTime = getFormattedNumber(communicator->getCurrentLamportTime());
-    std::cout << "[TS " << formattedLamportTime << ":" << getFormattedNumber(logMessageCounter++) << " " << getCurrentTime()
-               << " Process " <<  myProcessId << threadColor << " Thread " << threadId << rang::fg::reset << "]: "
-               << color << style << backgroundColor << message << rang::style::reset << rang::fg::reset << rang::bg::reset << std::endl;
+    // Written right away, so the message does not have to fit into a record
+    LogRecord record;
+    fill(record);
+    write(record, message, slot);
+    std::cout.flush();
+    writeTrace(record, message, slot);
+}
+
+Logger::ThreadSlot& Logger::getThreadSlot() {
+    thread_local ThreadSlot* slot = nullptr;
+    if (slot == nullptr) {
+        std::lock_guard<std::mutex> guard(mutex);
+        threads.push_back(std::make_unique<ThreadSlot>());
+        slot = threads.back().get();
+        slot->index = static_cast<unsigned short>(threads.size() - 1);
+    }
+    return *slot;
+}
+
+bool Logger::hasOutput() {
+    return consoleOutput or traceFile != nullptr;
+}
+
+ProcessId Logger::getProcessId(const ThreadSlot& slot) {
+    return slot.processId.has_value() ? slot.processId.value() : communicator->getProcessId();
+}
+
+void Logger::write(const LogRecord& record, std::string_view message, const ThreadSlot& slot) {
+    if (not consoleOutput) {
+        return;
+    }
+    ProcessId myProcessId = getProcessId(slot);
+    std::cout << "[TS " << getFormattedNumber(record.lamportTime) << ":" << getFormattedNumber(record.sequenceNumber)
+              << " " << getFormattedTime(record.wallTime) << " Process " <<  myProcessId << slot.color
+              << " Thread " << slot.name << rang::fg::reset << "]: " << record.color << record.style << backgroundColor;
+    if (record.hasContext) {
+        std::cout << "[" << record.context.state << myProcessId << " T" << record.context.transactionId << "] ";
+    }
+    std::cout << message << rang::style::reset << rang::fg::reset << rang::bg::reset << '\n';
+}
+
+void Logger::writeTrace(const LogRecord& record, std::string_view message, ThreadSlot& slot) {
+    if (traceFile == nullptr) {
+        return;
+    }
+    TraceRecordHeader header {};
+    header.rank = static_cast<uint32_t>(getProcessId(slot));
+    header.thread = slot.index;
+    if (slot.tracedName != slot.name) {
+        header.kind = TraceRecordKind::THREAD_NAME;
+        header.payloadLength = static_cast<uint16_t>(slot.name.size());
+        std::fwrite(&header, sizeof(header), 1, traceFile);
+        std::fwrite(slot.name.data(), 1, slot.name.size(), traceFile);
+        slot.tracedName = slot.name;
+    }
+    header.kind = TraceRecordKind::LOG_ENTRY;
+    header.lamportTime = record.lamportTime;
+    header.sequenceNumber = record.sequenceNumber;
+    header.wallTime = record.wallTime;
+    if (record.hasContext) {
+        header.flags |= TRACE_HAS_STATE;
+        header.state = static_cast<uint8_t>(record.context.state);
+        header.transactionId = record.context.transactionId;
+        if (record.context.messageType.has_value()) {
+            header.flags |= TRACE_HAS_MESSAGE_TYPE;
+            header.messageType = static_cast<uint8_t>(record.context.messageType.value());
+        }
+    }
+    header.payloadLength = static_cast<uint16_t>(std::min<std::size_t>(message.size(), UINT16_MAX));
+    std::fwrite(&header, sizeof(header), 1, traceFile);
+    std::fwrite(message.data(), 1, header.payloadLength, traceFile);
+}
+
+void Logger::writeAsynchronously() {
+    auto drain = [] {
+        std::lock_guard<std::mutex> guard(mutex);
+        return drainRings();
+    };
+    while (asynchronous.load()) {
+        Backoff backoff(WaitStrategy::BACKOFF);
+        while (drain() == 0 and asynchronous.load()) {
+            backoff.pause();
+        }
+    }
+}
+
+std::size_t Logger::drainRings(bool writeAll) {
+    const std::size_t alreadyPending = pending.size();
+    for (auto& slot : threads) {
+        ThreadSlot* owner = slot.get();
+        slot->ring.drain([&](const LogRecord& record) { pending.emplace_back(record, owner); });
+    }
+    const std::size_t drained = pending.size() - alreadyPending;
+    if (drained == 0 and not writeAll) {
+        return 0;
+    }
+    // Entries of different threads are interleaved back in the order in which they were logged
+    std::sort(pending.begin(), pending.end(), [](const auto& first, const auto& second) {
+        return first.first.sequenceNumber < second.first.sequenceNumber;
+    });
+    // Sequence numbers are only taken by successful pushes, so a gap is an entry still being pushed
+    auto ready = pending.begin();
+    while (ready != pending.end() and (writeAll or ready->first.sequenceNumber == nextSequenceNumber)) {
+        nextSequenceNumber = ready->first.sequenceNumber + 1;
+        ++ready;
+    }
+    if (ready == pending.begin()) {
+        return drained;
+    }
+    for (auto entry = pending.begin(); entry != ready; ++entry) {
+        write(entry->first, entry->first.getMessage(), *entry->second);
+    }
+    std::cout.flush();
+    if (traceFile != nullptr) {
+        // The trace merge tool expects the entries of every rank in the Lamport order, which the clocks of different
+        // threads only roughly follow across written runs
+        std::sort(pending.begin(), ready, [](const auto& first, const auto& second) {
+            return std::tie(first.first.lamportTime, first.first.sequenceNumber)
+                   < std::tie(second.first.lamportTime, second.first.sequenceNumber);
+        });
+        for (auto entry = pending.begin(); entry != ready; ++entry) {
+            writeTrace(entry->first, entry->first.getMessage(), *entry->second);
+        }
+    }
+    pending.erase(pending.begin(), ready);
+    return drained;
 }
 
 std::string Logger::getFormattedNumber(unsigned long number) {
@@ -37,10 +277,27 @@ std::string Logger::getFormattedNumber(unsigned long number) {
     return numberAsString;
 }
 
-std::string Logger::getCurrentTime() {
-    auto t = std::time(nullptr);
-    auto tm = *std::localtime(&t);
-    std::stringstream ss;
-    ss << std::put_time(&tm, "%H:%M:%S");
-    return ss.str();
+std::string Logger::getFormattedTime(std::time_t time) {
+    thread_local std::time_t cachedSecond = 0;
+    thread_local std::string cachedTime;
+    if (time != cachedSecond or cachedTime.empty()) {
+        std::tm tm {};
+        localtime_r(&time, &tm);
+        std::stringstream ss;
+        ss << std::put_time(&tm, "%H:%M:%S");
+        cachedSecond = time;
+        cachedTime = ss.str();
+    }
+    return cachedTime;
+}
+
+std::time_t Logger::getCurrentTime() {
+#ifdef CLOCK_REALTIME_COARSE
+    // Only whole seconds are printed, so the coarse clock is precise enough and several times cheaper to read
+    timespec now {};
+    clock_gettime(CLOCK_REALTIME_COARSE, &now);
+    return now.tv_sec;
+#else
+    return std::time(nullptr);
+#endif
 }
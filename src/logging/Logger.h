@@ -2,25 +2,106 @@
 #define INC_3PC_LOGGER_H
 
 #include <communication/ICommunicator.h>
+#include <util/SpscRing.h>
+#include <atomic>
 #include <thread>
-#include <map>
+#include <vector>
 #include <mutex>
 #include "ConsoleColor.h"
+#include "LogRecord.h"
+
+enum class LoggingMode : unsigned char {
+    /** Every entry is formatted and flushed to the standard output by the logging thread under a global lock */
+    SYNCHRONOUS,
+    /** Logging threads only fill a record in their own lock-free ring, a background thread formats and writes them */
+    ASYNCHRONOUS
+};
 
 class Logger {
 public:
-    static void init(std::shared_ptr<ICommunicator> communicator);
-    static void log(const std::string& message, rang::fg color = rang::fg::reset, rang::style style = rang::style::reset);
+    static void init(std::shared_ptr<ICommunicator> communicator, LoggingMode mode = LoggingMode::SYNCHRONOUS, bool consoleOutput = true);
+    static void log(std::string_view message, rang::fg color = rang::fg::reset, rang::style style = rang::style::reset);
+    static void log(const LogContext& context, std::string_view message);
+    /**
+     * Names the calling thread in the log entries and on the Timeline.
+     */
     static void registerThread(std::string threadFriendlyName, rang::fg consoleColor = rang::fg::reset);
 
+    /**
+     * Attributes the entries of the calling thread to the process of the given communicator instead of the one passed
+     * to init, for processes running as threads of a single program.
+     */
+    static void registerThread(std::string threadFriendlyName, const std::shared_ptr<ICommunicator>& processCommunicator,
+                               rang::fg consoleColor = rang::fg::reset);
+
+    /**
+     * Additionally writes every entry as a binary record (see TraceFormat.h) to the given file.
+     * Should be called right after init.
+     */
+    static void openTrace(const std::string& path);
+
+    /**
+     * Stops the background thread and writes out all pending entries, including those of threads which were pushing
+     * while the mode switched. Entries logged afterwards are written synchronously.
+     */
+    static void shutdown();
+
 private:
+    struct ThreadSlot {
+        std::string name;
+        rang::fg color = rang::fg::reset;
+        unsigned short index = 0;
+        /** Process the entries belong to and its clock, those of the communicator passed to init if not set */
+        std::optional<ProcessId> processId;
+        const LamportClock* lamportClock = nullptr;
+        /** Thread name as last written to the trace file */
+        std::optional<std::string> tracedName;
+        SpscRing<LogRecord, LOGGER_RING_CAPACITY> ring;
+        /** Set while the thread may push into its ring, so that shutdown can wait for pushes racing the mode switch */
+        std::atomic<bool> pushing = false;
+    };
+
+    static void log(const LogContext* context, std::string_view message, rang::fg color, rang::style style);
+    static ThreadSlot& getThreadSlot();
+    static ProcessId getProcessId(const ThreadSlot& slot);
+    /**
+     * Without console output and trace file entries are dropped right away, so that threads which would only log
+     * into the void do not even get a ring.
+     */
+    static bool hasOutput();
+    /**
+     * @param message Of the entry, which the record only holds if it went through a ring
+     */
+    static void write(const LogRecord& record, std::string_view message, const ThreadSlot& slot);
+    static void writeTrace(const LogRecord& record, std::string_view message, ThreadSlot& slot);
+    static void writeAsynchronously();
+    /**
+     * Moves the entries of all rings to the pending ones and writes those logged before the first missing sequence
+     * number, which a thread has taken but not pushed yet, so that the output is in the global order across batches.
+     * The mutex has to be held.
+     * @param writeAll Writes all pending entries, for when no more entries can arrive
+     * @return Number of entries taken from the rings
+     */
+    static std::size_t drainRings(bool writeAll = false);
+
     static std::string getFormattedNumber(unsigned long number);
-    static std::string getCurrentTime();
+    static std::string getFormattedTime(std::time_t time);
+    static std::time_t getCurrentTime();
 
     static std::mutex mutex;
-    static std::map<std::thread::id, std::pair<std::string, rang::fg>> threads;
-    static unsigned logMessageCounter;
+    static std::vector<std::unique_ptr<ThreadSlot>> threads;
+    static std::atomic<unsigned long> logMessageCounter;
     static std::shared_ptr<ICommunicator> communicator;
+    /** Clock of the communicator, read directly to keep logging free of virtual calls and locks */
+    static const LamportClock* lamportClock;
+    static std::atomic<bool> asynchronous;
+    static bool consoleOutput;
+    static std::thread writer;
+    /** Entries taken from the rings but not written yet, guarded by the mutex */
+    static std::vector<std::pair<LogRecord, ThreadSlot*>> pending;
+    /** Sequence number of the next entry to write in the asynchronous mode */
+    static unsigned long nextSequenceNumber;
+    static FILE* traceFile;
 };
 
 
@@ -0,0 +1,198 @@
+#include <cstdio>
+#include <set>
+#include <stdexcept>
+#include <util/StringConcat.h>
+#include "Timeline.h"
+
+std::atomic<bool> Timeline::enabled = false;
+std::mutex Timeline::mutex;
+std::string Timeline::path;
+std::vector<std::unique_ptr<Timeline::Track>> Timeline::tracks;
+
+namespace {
+    /** Chrome trace timestamps are in microseconds, fractions keep the nanoseconds */
+    void appendTimestamp(std::string& output, std::chrono::steady_clock::duration time) {
+        const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%lld.%03lld", static_cast<long long>(nanoseconds / 1000),
+                      static_cast<long long>(nanoseconds % 1000));
+        output += buffer;
+    }
+
+    void appendString(std::string& output, std::string_view text) {
+        output += '"';
+        for (char c : text) {
+            if (c == '"' or c == '\\') {
+                output += '\\';
+            }
+            output += c;
+        }
+        output += '"';
+    }
+}
+
+void Timeline::open(const std::string& path) {
+    std::lock_guard<std::mutex> guard(mutex);
+    Timeline::path = path;
+    enabled = true;
+}
+
+void Timeline::close() {
+    if (not enabled.exchange(false)) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(mutex);
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        throw std::runtime_error("Could not open the timeline file " + path);
+    }
+    // One event per line, so that the files of several ranks can be merged line by line
+    std::string output = "[";
+    const char* separator = "\n";
+    std::set<ProcessId> processes;
+    for (const auto& track : tracks) {
+        std::lock_guard<std::mutex> trackGuard(track->mutex);
+        if (processes.insert(track->processId).second) {
+            output += util::concat(separator, R"({"name":"process_name","ph":"M","pid":)", track->processId,
+                                   R"(,"args":{"name":")", track->processId == COORDINATOR_ID ? "Coordinator" : "Cohort member",
+                                   ' ', track->processId, R"("}})");
+            output += util::concat(",\n", R"({"name":"process_sort_index","ph":"M","pid":)", track->processId,
+                                   R"(,"args":{"sort_index":)", track->processId, "}}");
+            separator = ",\n";
+        }
+        output += util::concat(separator, R"({"name":"thread_name","ph":"M","pid":)", track->processId, R"(,"tid":)",
+                               track->index, R"(,"args":{"name":)");
+        appendString(output, track->name);
+        output += "}}";
+        separator = ",\n";
+        for (const Event& event : track->events) {
+            output += separator;
+            writeEvent(output, event, *track);
+        }
+        std::fwrite(output.data(), 1, output.size(), file);
+        output.clear();
+        track->events = std::vector<Event>();
+    }
+    output += "\n]\n";
+    std::fwrite(output.data(), 1, output.size(), file);
+    std::fclose(file);
+}
+
+void Timeline::registerThread(const std::string& name, ProcessId processId) {
+    if (not isEnabled()) {
+        return;
+    }
+    Track& track = getTrack();
+    std::lock_guard<std::mutex> guard(track.mutex);
+    // The Logger pads some names for the alignment of the console output
+    track.name = name.substr(0, name.find_last_not_of(' ') + 1);
+    track.processId = processId;
+}
+
+void Timeline::recordState(ProcessId processId, TransactionId transactionId, State state, TimePoint begin, TimePoint end) {
+    if (isEnabled()) {
+        append(Event {EventKind::STATE, begin, end, processId, transactionId, state, MessageType::CAN_COMMIT, processId, 0});
+    }
+}
+
+void Timeline::recordDecision(ProcessId processId, TransactionId transactionId, State state, TimePoint time) {
+    if (isEnabled()) {
+        append(Event {EventKind::DECISION, time, time, processId, transactionId, state, MessageType::CAN_COMMIT, processId, 0});
+    }
+}
+
+void Timeline::recordReceive(ProcessId processId, const Packet& packet, TimePoint time) {
+    if (isEnabled()) {
+        append(Event {EventKind::RECEIVE, time, time, processId, packet.transactionId, Q, packet.messageType,
+                      packet.source, packet.lamportTime});
+    }
+}
+
+Timeline::Track& Timeline::getTrack() {
+    thread_local Track* track = nullptr;
+    if (track == nullptr) {
+        std::lock_guard<std::mutex> guard(mutex);
+        tracks.push_back(std::make_unique<Track>());
+        track = tracks.back().get();
+        track->index = static_cast<unsigned>(tracks.size() - 1);
+    }
+    return *track;
+}
+
+void Timeline::append(const Event& event) {
+    Track& track = getTrack();
+    std::lock_guard<std::mutex> guard(track.mutex);
+    track.events.push_back(event);
+}
+
+std::string Timeline::getFlowId(ProcessId sender, LamportTime lamportTime, ProcessId recipient) {
+    return util::concat(sender, ".", lamportTime, ".", recipient);
+}
+
+void Timeline::writeEvent(std::string& output, const Event& event, const Track& track) {
+    // Fields every event starts with
+    auto begin = [&](std::string_view name, std::string_view category, char phase) {
+        output += R"({"name":)";
+        appendString(output, name);
+        output += util::concat(R"(,"cat":")", category, R"(","ph":")", phase, R"(","pid":)", event.processId, R"(,"tid":)",
+                               track.index);
+    };
+    switch (event.kind) {
+        case EventKind::STATE: {
+            // Async spans, so that every transaction gets a row of its own
+            begin(stateString.at(event.state), "transaction", 'b');
+            output += util::concat(R"(,"id":")", event.transactionId, R"(","args":{"transaction":)", event.transactionId, R"(},"ts":)");
+            appendTimestamp(output, event.begin.time_since_epoch());
+            output += "},\n";
+            begin(stateString.at(event.state), "transaction", 'e');
+            output += util::concat(R"(,"id":")", event.transactionId, R"(","ts":)");
+            appendTimestamp(output, event.end.time_since_epoch());
+            output += "}";
+            break;
+        }
+        case EventKind::DECISION: {
+            begin(event.state == C ? "Committed" : "Aborted", "transaction", 'i');
+            output += util::concat(R"(,"s":"t","args":{"transaction":)", event.transactionId, R"(},"ts":)");
+            appendTimestamp(output, event.begin.time_since_epoch());
+            output += "}";
+            break;
+        }
+        case EventKind::SEND: {
+            begin("send " + messageTypeString.at(event.messageType), "message", 'X');
+            output += util::concat(R"(,"args":{"transaction":)", event.transactionId, R"(,"lamportTime":)", event.lamportTime,
+                                   R"(},"dur":)");
+            appendTimestamp(output, event.end - event.begin);
+            output += R"(,"ts":)";
+            appendTimestamp(output, event.begin.time_since_epoch());
+            output += "}";
+            break;
+        }
+        case EventKind::FLOW_START: {
+            begin("message", "message", 's');
+            output += R"(,"id":)";
+            appendString(output, getFlowId(event.processId, event.lamportTime, event.peer));
+            output += R"(,"ts":)";
+            appendTimestamp(output, event.begin.time_since_epoch());
+            output += "}";
+            break;
+        }
+        case EventKind::RECEIVE: {
+            begin("receive " + messageTypeString.at(event.messageType), "message", 'X');
+            output += util::concat(R"(,"args":{"transaction":)", event.transactionId, R"(,"source":)", event.peer,
+                                   R"(,"lamportTime":)", event.lamportTime, R"(},"dur":0,"ts":)");
+            appendTimestamp(output, event.begin.time_since_epoch());
+            output += "}";
+            // Signals injected from outside the processes have no send to point back to
+            if (event.lamportTime > 0) {
+                output += ",\n";
+                begin("message", "message", 'f');
+                output += R"(,"bp":"e","id":)";
+                appendString(output, getFlowId(event.peer, event.lamportTime, event.processId));
+                output += R"(,"ts":)";
+                appendTimestamp(output, event.begin.time_since_epoch());
+                output += "}";
+            }
+            break;
+        }
+    }
+}
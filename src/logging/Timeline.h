@@ -0,0 +1,121 @@
+#ifndef INC_3PC_TIMELINE_H
+#define INC_3PC_TIMELINE_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <communication/ICommunicator.h>
+
+/**
+ * Records the protocol activity of the processes as Chrome trace events, viewable in chrome://tracing or Perfetto.
+ * Every thread registered with the Logger gets a track under its process, states of transactions become spans of
+ * their own and every message is an arrow from its send to its receive. The arrows are matched by the sender,
+ * the Lamport time of the send and the recipient, so the tracks of different ranks can be merged afterwards.
+ *
+ * Recording only appends to a buffer of the calling thread. Nothing is written before close(), so that file output does
+ * not perturb the recorded timings.
+ */
+class Timeline {
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    /**
+     * Starts recording, the events are written to the given file by close().
+     */
+    static void open(const std::string& path);
+
+    /**
+     * Writes all the recorded events and stops recording.
+     */
+    static void close();
+
+    static bool isEnabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Names the track of the calling thread. Called by Logger::registerThread.
+     */
+    static void registerThread(const std::string& name, ProcessId processId);
+
+    /**
+     * Records the time a transaction spent in a state.
+     */
+    static void recordState(ProcessId processId, TransactionId transactionId, State state, TimePoint begin, TimePoint end);
+
+    /**
+     * Records the decision on a transaction.
+     */
+    static void recordDecision(ProcessId processId, TransactionId transactionId, State state, TimePoint time);
+
+    /**
+     * Records sending the given packet to every recipient, which took from begin until end.
+     */
+    template <typename Recipients>
+    static void recordSend(const Packet& packet, const Recipients& recipients, TimePoint begin, TimePoint end);
+
+    /**
+     * Records the arrival of the given packet at the process.
+     */
+    static void recordReceive(ProcessId processId, const Packet& packet, TimePoint time);
+
+private:
+    enum class EventKind : unsigned char {
+        STATE, DECISION, SEND, FLOW_START, RECEIVE
+    };
+
+    struct Event {
+        EventKind kind;
+        TimePoint begin;
+        TimePoint end;
+        ProcessId processId;
+        TransactionId transactionId;
+        State state;
+        MessageType messageType;
+        /** Recipient of a flow start, source of a receive */
+        ProcessId peer;
+        /** Send time at the sender of the message of a send, flow start or receive */
+        LamportTime lamportTime;
+    };
+
+    /**
+     * Events of one thread. Only its thread appends to it, the lock is contended by close() only.
+     */
+    struct Track {
+        std::string name = "Thread";
+        ProcessId processId = 0;
+        unsigned index = 0;
+        std::mutex mutex;
+        std::vector<Event> events;
+    };
+
+    static Track& getTrack();
+    static void append(const Event& event);
+    static std::string getFlowId(ProcessId sender, LamportTime lamportTime, ProcessId recipient);
+    static void writeEvent(std::string& output, const Event& event, const Track& track);
+
+    static std::atomic<bool> enabled;
+    static std::mutex mutex;
+    static std::string path;
+    static std::vector<std::unique_ptr<Track>> tracks;
+};
+
+template <typename Recipients>
+void Timeline::recordSend(const Packet& packet, const Recipients& recipients, TimePoint begin, TimePoint end) {
+    if (not isEnabled()) {
+        return;
+    }
+    Event event {EventKind::SEND, begin, end, packet.source, packet.transactionId, Q, packet.messageType, packet.source,
+                 packet.lamportTime};
+    append(event);
+    event.kind = EventKind::FLOW_START;
+    for (ProcessId recipient : recipients) {
+        event.peer = recipient;
+        append(event);
+    }
+}
+
+#endif //INC_3PC_TIMELINE_H
@@ -0,0 +1,52 @@
+#ifndef INC_3PC_TRACEFORMAT_H
+#define INC_3PC_TRACEFORMAT_H
+
+#include <cstdint>
+
+/**
+ * Layout of the binary per-rank trace files written by the Logger and read by the trace merge tool.
+ *
+ * A file starts with a TraceFileHeader followed by a stream of records. Each record is a TraceRecordHeader directly
+ * followed by payloadLength bytes of payload: the log message for LOG_ENTRY records or the thread name for THREAD_NAME
+ * records. A THREAD_NAME record precedes the first entry of every thread. Log entries are ordered by
+ * (lamportTime, sequenceNumber) within each flushed batch, and batches follow each other in the order of logging, so
+ * readers have to expect entries slightly out of the Lamport order across batches. All integers are stored in the
+ * writer's byte order.
+ */
+
+#define TRACE_MAGIC "3PCTRACE"
+#define TRACE_VERSION 1
+
+struct TraceFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t rank;
+};
+
+enum class TraceRecordKind : uint8_t {
+    LOG_ENTRY, THREAD_NAME
+};
+
+enum TraceRecordFlags : uint8_t {
+    TRACE_HAS_STATE = 1,
+    TRACE_HAS_MESSAGE_TYPE = 2
+};
+
+struct TraceRecordHeader {
+    uint64_t lamportTime;
+    uint64_t sequenceNumber;
+    int64_t wallTime;
+    uint32_t rank;
+    uint32_t transactionId;
+    uint16_t thread;
+    uint16_t payloadLength;
+    TraceRecordKind kind;
+    uint8_t flags;
+    uint8_t state;
+    uint8_t messageType;
+};
+
+static_assert(sizeof(TraceFileHeader) == 16, "Trace file header must not contain padding");
+static_assert(sizeof(TraceRecordHeader) == 40, "Trace record header must not contain padding");
+
+#endif //INC_3PC_TRACEFORMAT_H
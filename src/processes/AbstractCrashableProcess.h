@@ -1,14 +1,49 @@
 #ifndef INC_3PC_ABSTRACTCRASHABLEPROCESS_H
 #define INC_3PC_ABSTRACTCRASHABLEPROCESS_H
 
+#include <sys/resource.h>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <communication/ICollectiveVoting.h>
+#include <communication/MessageBundle.h>
+#include <logging/Timeline.h>
+#include <storage/WriteAheadLog.h>
+#include <util/LatencyRecorder.h>
+#include <util/RttEstimator.h>
 #include "AbstractProcess.h"
+#include "FailureDetector.h"
+#include "ParticipantSets.h"
+#include "TreeTopology.h"
 
 template <typename Tag>
 class AbstractCrashableProcess : public AbstractProcess {
 public:
 
-    explicit AbstractCrashableProcess(std::shared_ptr<ITaggedCommunicator<Tag>> communicator, Tag defaultTag, Tag crashTag)
-        : AbstractProcess(std::move(communicator)), defaultTag(defaultTag), crashTag(crashTag) {
+    explicit AbstractCrashableProcess(std::shared_ptr<ITaggedCommunicator<Tag>> communicator, Tag defaultTag, Tag crashTag,
+                                      Tag heartbeatTag, std::shared_ptr<ICollectiveVoting> collectiveVoting = nullptr)
+        : AbstractProcess(std::move(communicator)), collectiveVoting(std::move(collectiveVoting)), defaultTag(defaultTag),
+          crashTag(crashTag) {
+        const auto& configuration = Configuration::get();
+        if (not configuration.walPrefix.empty()) {
+            writeAheadLog = std::make_unique<WriteAheadLog>(
+                    util::concat(configuration.walPrefix, ".", this->communicator->getProcessId(), ".wal"),
+                    this->communicator->getProcessId(), configuration.recover,
+                    static_cast<std::size_t>(configuration.checkpointInterval));
+        }
+        if (this->communicator->getProcessId() == COORDINATOR_ID) {
+            const auto children = topology.getChildren();
+            bundleRecipients = RankSet(children.begin(), children.end());
+        } else {
+            bundleRecipients.insert(topology.getParent());
+        }
+        if (configuration.failureDetector) {
+            failureDetector = std::make_unique<FailureDetector<Tag>>(getTaggedCommunicator(), getWatchedPeers(), heartbeatTag,
+                                                                     defaultTag, std::chrono::milliseconds(configuration.heartbeatInterval),
+                                                                     std::chrono::milliseconds(configuration.suspicionTimeout));
+        }
+        // Started last, as a crash signal is recorded through the failure detector
         crashSignalReceiver = std::thread([=]{ receiveCrashSignal(crashTag); });
     }
 
@@ -17,34 +52,541 @@ public:
     }
 
     virtual ~AbstractCrashableProcess() {
+        stop();
         crashSignalReceiver.join();
     }
 
+    /**
+     * Makes the process, its crash signal receiver and its failure detector finish. Called by the destructor at
+     * the latest, which then waits for the receiver.
+     */
+    void stop() {
+        if (stopped.exchange(true)) {
+            return;
+        }
+        terminate = true;
+        if (failureDetector != nullptr) {
+            failureDetector->stop();
+        }
+        // Wakes the crash signal receiver up instead of waiting for its poll to time out
+        getTaggedCommunicator()->send(0, MessageType::CRASH, "", communicator->getProcessId(), crashTag);
+    }
+
+    /**
+     * Writes the protocol metrics and the communication counters of the process to <metricsPrefix>.<rank>.metrics,
+     * if a prefix is configured.
+     */
+    void writeMetrics() const {
+        const auto& metricsPrefix = Configuration::get().metricsPrefix;
+        if (metricsPrefix.empty()) {
+            return;
+        }
+        const std::string path = util::concat(metricsPrefix, ".", communicator->getProcessId(), ".metrics");
+        std::ofstream output(path);
+        if (not output) {
+            throw std::runtime_error("Could not open the metrics file " + path);
+        }
+        MetricsDump metricsDump;
+        metrics.dump(metricsDump, communicator->getCounters());
+        metricsDump.write(output);
+    }
+
 protected:
 
     void receiveCrashSignal(Tag crashTag) {
-        Logger::registerThread("Crash");
-        while (not terminate) {
-            auto potentialPacket = getTaggedCommunicator()->receive(500, crashTag);
-            if (potentialPacket.has_value()) {
+        Logger::registerThread("Crash", communicator);
+        // No timeout needed, stop() wakes the receiver up. Receives at least once even if the process finished before
+        // the thread started, as a simulated network does not advance time until every thread of a process waited on it.
+        do {
+            Packet packet = getTaggedCommunicator()->receive(crashTag);
+            if (not terminate) {
+                recordReceive(packet);
                 Logger::log("Received crash signal");
                 crashSignalReceived = true;
             }
-        }
+        } while (not terminate);
     }
 
     void crashIfSignalled() {
         if (crashSignalReceived.load()) {
-            logWithState("Committing suicide...");
+            Logger::log(util::concat("[", communicator->getProcessId(), "] Committing suicide..."));
             terminate = true;
+            // A crashed process falls silent right away, so that its peers can suspect it
+            if (failureDetector != nullptr) {
+                failureDetector->stop();
+            }
+        }
+    }
+
+    /**
+     * @return The peers the failure detector watches, its neighbours in the tree: in the star, the coordinator watches
+     * the cohort and every cohort member watches the coordinator, so the heartbeats grow linearly with the number of
+     * processes
+     */
+    std::vector<ProcessId> getWatchedPeers() const {
+        std::vector<ProcessId> peers = topology.getChildren();
+        if (communicator->getProcessId() != COORDINATOR_ID) {
+            peers.insert(peers.begin(), topology.getParent());
+        }
+        return peers;
+    }
+
+    /**
+     * @return Whether the failure detector suspects the given peer to have crashed
+     */
+    bool isSuspected(ProcessId peer) const {
+        return failureDetector != nullptr and failureDetector->isSuspected(peer);
+    }
+
+    std::vector<ProcessId> getSuspects() const {
+        return failureDetector != nullptr ? failureDetector->getSuspects() : std::vector<ProcessId>();
+    }
+
+    /**
+     * Moves the transaction to the given state after the usual pause between protocol steps. Transactions entering
+     * a final state are removed from the table, the others get a fresh round time deadline for the new phase.
+     */
+    void enterState(Transaction& transaction, State newState) {
+        const auto now = communicator->now();
+        metrics.stateDuration(transaction.state).record(now - transaction.phaseStartTime);
+        Timeline::recordState(communicator->getProcessId(), transaction.id, transaction.state, transaction.phaseStartTime, now);
+        transaction.phaseStartTime = now;
+        transaction.state = newState;
+        sleep();
+        crashIfSignalled();
+        if (terminate) {
+            return;
+        }
+        if ((newState == A or newState == C) and transaction.collective) {
+            collectiveVoting->release(transaction.id);
+        }
+        if (writeAheadLog != nullptr) {
+            logTransition(transaction, newState);
+        }
+        if (newState == A or newState == C) {
+            Timeline::recordDecision(communicator->getProcessId(), transaction.id, newState, communicator->now());
+        }
+        switch (newState) {
+            case A: {
+                logWithState(transaction, "Entered state A - aborted the transaction!");
+                deliver(transaction, 0);
+                transactions.erase(transaction.id);
+                break;
+            }
+            case C: {
+                logWithState(transaction, "Entered state C - committed the transaction!");
+                deliver(transaction, transaction.batchMask);
+                transactions.erase(transaction.id);
+                break;
+            }
+            default: {
+                logWithState(transaction, util::concat("Entered state ", newState));
+                transaction.responders.clear();
+                transaction.responsesAsExpected = true;
+                transactions.setDeadline(transaction, communicator->now() + getPhaseTimeout());
+            }
         }
     }
 
+    /**
+     * Hands the outcome of a decided transaction over, which is removed from the table right after. Records it right
+     * away unless overridden.
+     */
+    virtual void deliver(Transaction& transaction, uint64_t committedMask) {
+        recordOutcome(transaction, committedMask);
+    }
+
+    /**
+     * Counts every transaction of the batch, the ones in the given mask as committed and the others as aborted.
+     */
+    void recordOutcome(const Transaction& transaction, uint64_t committedMask) {
+        const auto now = communicator->now();
+        for (unsigned i = 0; i < transaction.batchSize; ++i) {
+            auto& outcome = (committedMask >> i) & 1 ? metrics.committed : metrics.aborted;
+            outcome.fetch_add(1, std::memory_order_relaxed);
+            latencies.record(now - (transaction.arrivalTimes.empty() ? transaction.startTime : transaction.arrivalTimes[i]));
+        }
+    }
+
+    void logTransition(const Transaction& transaction, State newState) {
+        if (not writeAheadLog->hasUnsynced()) {
+            groupCommitDeadline = communicator->now() + std::chrono::microseconds(Configuration::get().groupCommitWindow);
+        }
+        writeAheadLog->append(transaction.id, newState);
+        metrics.loggedRecords.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @return Whether the process resumes from its write-ahead log
+     */
+    bool isRecovering() const {
+        return writeAheadLog != nullptr and Configuration::get().recover;
+    }
+
+    /**
+     * Puts the transactions which were in flight when the process went down back into the table, in the state
+     * the write-ahead log has for them.
+     * @return The ids of the restored transactions in ascending order
+     */
+    std::vector<TransactionId> restoreTransactions() {
+        const auto& recovery = writeAheadLog->getRecovery();
+        std::vector<TransactionId> ids;
+        for (const auto& [id, state] : recovery.inFlight) {
+            Transaction& transaction = transactions.insert(id);
+            transaction.state = state;
+            transaction.startTime = communicator->now();
+            transaction.phaseStartTime = transaction.startTime;
+            ids.push_back(id);
+        }
+        Logger::log(util::concat("[", communicator->getProcessId(), "] Recovered ", ids.size(), " transaction(s) in flight from ",
+                                 recovery.records, " log record(s) in ",
+                                 std::chrono::duration<double, std::milli>(recovery.duration).count(), " ms"));
+        return ids;
+    }
+
+    /**
+     * Makes the logged state transitions durable and then sends the messages which depend on them.
+     */
+    void commitLog() {
+        if (writeAheadLog == nullptr) {
+            return;
+        }
+        if (writeAheadLog->hasUnsynced()) {
+            const auto begin = communicator->now();
+            writeAheadLog->sync();
+            metrics.logSyncDuration().record(communicator->now() - begin);
+            metrics.logSyncs.fetch_add(1, std::memory_order_relaxed);
+        }
+        std::vector<std::function<void()>> sends;
+        sends.swap(deferredSends);
+        for (auto& send : sends) {
+            send();
+        }
+    }
+
+    /**
+     * Sends like sendRecorded, but with a write-ahead log only after the next commitLog(), so that the message never
+     * gets ahead of the state transition it announces. The recipients have to outlive the send.
+     */
+    template <typename Recipients, typename Send>
+    void sendDurably(const Recipients& recipients, Send send) {
+        if (writeAheadLog == nullptr) {
+            sendRecorded(recipients, send);
+            return;
+        }
+        deferredSends.emplace_back([this, &recipients, send] { sendRecorded(recipients, send); });
+    }
+
+    /**
+     * Sends a message about the transaction to the next level of the tree, i.e. from the coordinator to its children
+     * or from a cohort member to its parent. Deferred until the next commitLog() like sendDurably. With
+     * piggybacking, the message waits in the outbox until the process runs out of packets to handle, so that the
+     * messages of all the transactions handled until then go out as a single BUNDLE packet.
+     */
+    void sendToPeers(TransactionId transactionId, MessageType messageType, const std::string& message) {
+        if (writeAheadLog != nullptr) {
+            deferredSends.emplace_back([this, transactionId, messageType, message] { post(transactionId, messageType, message); });
+            return;
+        }
+        post(transactionId, messageType, message);
+    }
+
+    /**
+     * Sends the messages waiting in the outbox, more than one of them as a bundle.
+     */
+    void flushOutbox() {
+        if (outbox.empty()) {
+            return;
+        }
+        if (outbox.size() == 1) {
+            MessageBundle::forEachEntry(outbox.getEncoded(), [&](const MessageBundle::Entry& entry) {
+                sendToPeersNow(entry.transactionId, entry.messageType, std::string(entry.message));
+            });
+        } else {
+            metrics.piggybackedMessages.fetch_add(outbox.size(), std::memory_order_relaxed);
+            // The bundle carries the id of its first transaction, for the logs and the Timeline
+            TransactionId firstTransactionId = 0;
+            std::memcpy(&firstTransactionId, outbox.getEncoded().data(), sizeof(uint32_t));
+            sendToPeersNow(firstTransactionId, MessageType::BUNDLE, outbox.getEncoded());
+        }
+        outbox.clear();
+    }
+
+    /**
+     * Records how long the transaction has been waiting in its current state for a packet of the given type.
+     */
+    void recordMessageWait(const Transaction& transaction, MessageType messageType) {
+        metrics.messageWait(messageType).record(communicator->now() - transaction.phaseStartTime);
+    }
+
+    /**
+     * @return How long to wait for the next message of a phase
+     */
+    virtual std::chrono::steady_clock::duration getPhaseTimeout() = 0;
+
+    /**
+     * @return The round time, or with adaptive timeouts a timeout derived from the round-trip times to the given peers
+     */
+    template <typename Peers>
+    std::chrono::steady_clock::duration getTimeoutFor(const Peers& peers) {
+        if (not Configuration::get().adaptiveTimeouts) {
+            return std::chrono::milliseconds(Configuration::get().roundTime);
+        }
+        return roundTripTimes.getTimeout(peers);
+    }
+
+    /**
+     * Waits for the next packet on the default tag or from collective voting, but no longer than until the earliest
+     * transaction deadline (or the round time if no transaction awaits anything). Bundles are taken apart, their
+     * messages are returned one by one.
+     * @param wakeUpTime Another deadline to return at, if any
+     */
+    std::optional<Packet> receiveUntilNextDeadline(std::optional<std::chrono::steady_clock::time_point> wakeUpTime = std::nullopt) {
+        if (unbundledPackets.empty()) {
+            auto packet = receiveNextPacket(wakeUpTime);
+            if (not packet.has_value() or packet->messageType != MessageType::BUNDLE) {
+                return packet;
+            }
+            unbundle(packet.value());
+            if (unbundledPackets.empty()) {
+                return std::nullopt;
+            }
+        }
+        Packet packet = std::move(unbundledPackets.front());
+        unbundledPackets.pop_front();
+        return packet;
+    }
+
+    std::optional<Packet> receiveNextPacket(std::optional<std::chrono::steady_clock::time_point> wakeUpTime) {
+        using namespace std::chrono;
+        if (writeAheadLog != nullptr and (writeAheadLog->hasUnsynced() or not deferredSends.empty())) {
+            // Group commit: packets which are already waiting are handled first, so that their transitions share the flush
+            if (communicator->now() < groupCommitDeadline) {
+                auto packet = getTaggedCommunicator()->receive(0, defaultTag);
+                if (packet.has_value() and not isWakeUp(packet.value())) {
+                    recordReceive(packet.value());
+                    return packet;
+                }
+            }
+            commitLog();
+        }
+        if (not outbox.empty()) {
+            // Likewise, the messages caused by packets which are already waiting join the bundle
+            auto packet = getTaggedCommunicator()->receive(0, defaultTag);
+            if (packet.has_value() and not isWakeUp(packet.value())) {
+                recordReceive(packet.value());
+                return packet;
+            }
+            flushOutbox();
+        }
+        long timeoutMillis = Configuration::get().roundTime;
+        auto nextDeadline = transactions.nextDeadline();
+        if (wakeUpTime.has_value() and (not nextDeadline.has_value() or wakeUpTime.value() < nextDeadline.value())) {
+            nextDeadline = wakeUpTime;
+        }
+        if (nextDeadline.has_value()) {
+            timeoutMillis = std::max(0L, static_cast<long>(ceil<milliseconds>(nextDeadline.value() - communicator->now()).count()));
+        }
+        if (collectiveVoting == nullptr) {
+            auto packet = getTaggedCommunicator()->receive(timeoutMillis, defaultTag);
+            if (packet.has_value() and isWakeUp(packet.value())) {
+                return std::nullopt;
+            }
+            if (packet.has_value()) {
+                recordReceive(packet.value());
+            }
+            return packet;
+        }
+
+        // Collective operations only progress when tested, so both sources are polled in turns
+        std::optional<Packet> packet;
+        Backoff backoff(Configuration::get().waitStrategy);
+        backoff.pollUntil([&] {
+            packet = collectiveVoting->poll();
+            if (not packet.has_value()) {
+                packet = getTaggedCommunicator()->receive(0, defaultTag);
+                if (packet.has_value() and not isWakeUp(packet.value())) {
+                    retireCollectiveChannelOnPointToPoint(packet.value());
+                }
+            }
+            return packet.has_value();
+        }, communicator->now() + milliseconds(timeoutMillis));
+        if (packet.has_value() and isWakeUp(packet.value())) {
+            return std::nullopt;
+        }
+        if (packet.has_value()) {
+            recordReceive(packet.value());
+        }
+        return packet;
+    }
+
+    /**
+     * Adds the message to the outbox if piggybacking is enabled, or sends it right away.
+     */
+    void post(TransactionId transactionId, MessageType messageType, const std::string& message) {
+        if (not Configuration::get().piggyback) {
+            sendToPeersNow(transactionId, messageType, message);
+            return;
+        }
+        if (not outbox.fits(message)) {
+            flushOutbox();
+            if (not outbox.fits(message)) {
+                sendToPeersNow(transactionId, messageType, message);
+                return;
+            }
+        }
+        outbox.add(transactionId, messageType, message);
+    }
+
+    void sendToPeersNow(TransactionId transactionId, MessageType messageType, const std::string& message) {
+        sendRecorded(bundleRecipients, [&] {
+            if (bundleRecipients.size() == 1) {
+                return getTaggedCommunicator()->send(transactionId, messageType, message, *bundleRecipients.begin(), defaultTag);
+            }
+            return getTaggedCommunicator()->send(transactionId, messageType, message, bundleRecipients, defaultTag);
+        });
+    }
+
+    /**
+     * Queues the messages of a received bundle as packets of their own, which share the source and the Lamport time
+     * of the bundle.
+     */
+    void unbundle(const Packet& bundle) {
+        const bool wellFormed = MessageBundle::forEachEntry(bundle.message, [&](const MessageBundle::Entry& entry) {
+            PooledBuffer buffer = communicator->getBufferPool().acquire(entry.message.size());
+            std::memcpy(buffer.data(), entry.message.data(), entry.message.size());
+            const auto message = buffer.view();
+            unbundledPackets.push_back(Packet {bundle.lamportTime, bundle.source, entry.transactionId, entry.messageType,
+                                               message, std::move(buffer)});
+        });
+        if (not wellFormed) {
+            logUnexpectedPacket(bundle);
+        }
+    }
+
+    /**
+     * Sends a packet to the given recipients with the given function and records the send on the Timeline.
+     */
+    template <typename Recipients, typename Send>
+    void sendRecorded(const Recipients& recipients, Send send) {
+        if (failureDetector != nullptr) {
+            failureDetector->sent(recipients);
+        }
+        if (not Timeline::isEnabled()) {
+            send();
+            return;
+        }
+        const auto begin = communicator->now();
+        Packet packet = send();
+        Timeline::recordSend(packet, recipients, begin, communicator->now());
+    }
+
+    /**
+     * @return Whether the packet is the failure detector waking the main thread up to look at a new suspicion
+     */
+    bool isWakeUp(const Packet& packet) const {
+        return packet.messageType == MessageType::HEARTBEAT and packet.source == communicator->getProcessId();
+    }
+
+    void recordReceive(const Packet& packet) {
+        if (failureDetector != nullptr) {
+            failureDetector->heard(packet.source);
+        }
+        if (Timeline::isEnabled()) {
+            Timeline::recordReceive(communicator->getProcessId(), packet, communicator->now());
+        }
+    }
+
+    /**
+     * Makes the transaction use point-to-point messages from now on. Needed whenever this process stops waiting for
+     * a collective operation, as such an operation can never be cancelled.
+     */
+    void retireCollectiveChannel(Transaction& transaction) {
+        if (transaction.collective) {
+            collectiveVoting->retire(transaction.id);
+            transaction.collective = false;
+            logWithState(transaction, "Retired the collective channel of the transaction - switched to point-to-point messages");
+        }
+    }
+
+    /**
+     * A point-to-point message about a transaction running on a collective channel means the sender has retired
+     * the channel, so this process does it too.
+     */
+    void retireCollectiveChannelOnPointToPoint(const Packet& packet) {
+        Transaction* transaction = transactions.find(packet.transactionId);
+        if (transaction != nullptr) {
+            retireCollectiveChannel(*transaction);
+        }
+    }
+
+    void logSummary() {
+        const auto committed = metrics.committed.load(std::memory_order_relaxed);
+        const auto aborted = metrics.aborted.load(std::memory_order_relaxed);
+        Logger::log(util::concat("[", communicator->getProcessId(), "] Finished ", committed + aborted,
+                                 " transaction(s): ", committed, " committed, ", aborted, " aborted"));
+        if (Configuration::get().benchmark) {
+            printBenchmarkReport();
+        }
+    }
+
+    /**
+     * Prints throughput, decision latency and CPU usage of this process to the standard output in a single line.
+     */
+    void printBenchmarkReport() {
+        using namespace std::chrono;
+        double wallSeconds = duration<double>(communicator->now() - startTime).count();
+        double cpuSeconds = getCpuSeconds() - startCpuSeconds;
+        std::string logReport;
+        if (writeAheadLog != nullptr) {
+            const auto records = metrics.loggedRecords.load(std::memory_order_relaxed);
+            const auto syncs = metrics.logSyncs.load(std::memory_order_relaxed);
+            logReport = util::concat(", ", records / wallSeconds, " logged transitions/s in ", syncs, " flushes (",
+                                     syncs > 0 ? static_cast<double>(records) / syncs : 0.0, " per flush)");
+        }
+        std::cout << util::concat("[Benchmark] Process ", communicator->getProcessId(), ": ", latencies.count(),
+                                  " transactions in ", wallSeconds * 1000, " ms (", latencies.count() / wallSeconds,
+                                  " tx/s), latency ", latencies.summary(), ", CPU ", cpuSeconds / wallSeconds,
+                                  " s per wall second", logReport) << std::endl;
+    }
+
+    static double getCpuSeconds() {
+        rusage usage {};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    }
+
+    TransactionTable transactions;
+    TreeTopology topology {communicator->getProcessId(), communicator->getNumberOfProcesses(), Configuration::get().fanOut};
+    ParticipantSets participantSets {communicator->getProcessId(), communicator->getNumberOfProcesses(), Configuration::get().participants};
+    /** Transport of requests and responses as collective operations, or nullptr if only point-to-point messages are used */
+    std::shared_ptr<ICollectiveVoting> collectiveVoting;
+    LatencyRecorder latencies;
+    RttEstimator roundTripTimes {static_cast<std::size_t>(communicator->getNumberOfProcesses()),
+                                 std::chrono::milliseconds(Configuration::get().minTimeout),
+                                 std::chrono::milliseconds(Configuration::get().roundTime), Configuration::get().timeoutPercentile};
+    std::chrono::steady_clock::time_point startTime = communicator->now();
+    double startCpuSeconds = getCpuSeconds();
     std::thread crashSignalReceiver;
     std::atomic<bool> crashSignalReceived = false;
     std::atomic<bool> terminate = false;
+    std::atomic<bool> stopped = false;
+    /** Only if enabled in the configuration */
+    std::unique_ptr<WriteAheadLog> writeAheadLog;
+    /** Sends waiting for the next flush of the write-ahead log */
+    std::vector<std::function<void()>> deferredSends;
+    /** Until when logged transitions may wait for more transitions to share their flush */
+    std::chrono::steady_clock::time_point groupCommitDeadline;
+    /** Messages of sendToPeers waiting to be sent together, only used with piggybacking */
+    MessageBundle outbox {std::min<std::size_t>(BUNDLE_CAPACITY, communicator->getMaxMessageSize())};
+    /** The next level of the tree, which every message of the outbox goes to: children of the coordinator, parent of a cohort member */
+    RankSet bundleRecipients;
+    /** Messages of a received bundle which are still to be handled */
+    std::deque<Packet> unbundledPackets;
     Tag defaultTag;
     Tag crashTag;
+    /** Only if enabled in the configuration */
+    std::unique_ptr<FailureDetector<Tag>> failureDetector;
 };
 
 #endif //INC_3PC_ABSTRACTCRASHABLEPROCESS_H
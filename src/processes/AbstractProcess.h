@@ -6,37 +6,67 @@
 #include <util/Define.h>
 #include <communication/ICommunicator.h>
 #include <util/StringConcat.h>
+#include <util/Configuration.h>
+#include <util/Metrics.h>
+#include <logging/Logger.h>
+#include "TransactionTable.h"
 
 class AbstractProcess {
 
 public:
-    explicit AbstractProcess(std::shared_ptr<ICommunicator> communicator) : communicator(std::move(communicator)) { }
+    explicit AbstractProcess(std::shared_ptr<ICommunicator> communicator)
+        : communicator(std::move(communicator)), random(createRandom(this->communicator->getProcessId())) { }
 
     virtual void run() = 0;
 
     virtual void sleep() {
-        std::this_thread::sleep_for(std::chrono::milliseconds(random.randomBetween(MIN_SLEEP_TIME, MAX_SLEEP_TIME)));
+        sleepBetween(Configuration::get().minSleepTime, Configuration::get().maxSleepTime);
     }
 
 protected:
 
+    void sleepBetween(long minMillis, long maxMillis) {
+        if (maxMillis > 0) {
+            communicator->sleepFor(std::chrono::milliseconds(random.randomBetween(minMillis, maxMillis)));
+        }
+    }
+
     void logUnexpectedPacket(const Packet& p) {
-        logWithState("Unexpected packet received: " + printPacket(p));
+        metrics.unexpectedPackets.fetch_add(1, std::memory_order_relaxed);
+        Logger::log(util::concat("[", communicator->getProcessId(), "] Unexpected packet received: ", printPacket(p)));
+    }
+
+    void logUnexpectedPacket(const Transaction& transaction, const Packet& p) {
+        metrics.unexpectedPackets.fetch_add(1, std::memory_order_relaxed);
+        logWithState(transaction, "Unexpected packet received: " + printPacket(p), p.messageType);
     }
 
-    void logWithState(const std::string& message) {
-        Logger::log(util::concat("[", stateString.at(state), communicator->getProcessId(), "] ", message));
+    void logWithState(const Transaction& transaction, std::string_view message) {
+        Logger::log(LogContext {transaction.state, transaction.id}, message);
+    }
+
+    void logWithState(const Transaction& transaction, std::string_view message, MessageType messageType) {
+        Logger::log(LogContext {transaction.state, transaction.id, messageType}, message);
     }
 
     static std::string printPacket(const Packet& p) {
-        return util::concat("TS: ", p.lamportTime, ", source: ", p.source, ", type: ", messageTypeString.at(p.messageType), ", message: ", p.message);
+        return util::concat("TS: ", p.lamportTime, ", source: ", p.source, ", transaction: ", p.transactionId,
+                            ", type: ", messageTypeString.at(p.messageType), ", message: ", p.message);
+    }
+
+    /**
+     * @return Generator seeded from the configured seed, so that runs can be reproduced, or from the time if there is none
+     */
+    static Random createRandom(ProcessId processId) {
+        const auto& seed = Configuration::get().seed;
+        return seed.has_value() ? Random(seed.value() + static_cast<unsigned>(processId)) : Random();
     }
 
     std::shared_ptr<ICommunicator> communicator;
 
     Random random;
 
-    State state;
+    ProtocolMetrics metrics;
 };
 
 #endif //INC_3PC_ABSTRACTPROCESS_H
@@ -2,107 +2,860 @@
 #define INC_3PC_COHORTMEMBER_H
 
 
+#include <algorithm>
+#include <array>
+#include <map>
+#include <optional>
+#include <vector>
 #include <logging/Logger.h>
-#include "AbstractProcess.h"
+#include "AbstractCrashableProcess.h"
 
 template <typename Tag>
 class CohortMember : public AbstractCrashableProcess<Tag> {
 public:
 
-    explicit CohortMember(std::shared_ptr<ITaggedCommunicator<Tag>> communicator, Tag defaultTag, Tag crashTag)
-        : AbstractCrashableProcess<Tag>(std::move(communicator), defaultTag, crashTag) {
-        this->state = Q;
+    explicit CohortMember(std::shared_ptr<ITaggedCommunicator<Tag>> communicator, Tag defaultTag, Tag crashTag, Tag heartbeatTag,
+                          std::shared_ptr<ICollectiveVoting> collectiveVoting = nullptr)
+        : AbstractCrashableProcess<Tag>(std::move(communicator), defaultTag, crashTag, heartbeatTag, std::move(collectiveVoting)),
+          parent {this->topology.getParent()}, children(this->topology.getChildren()), childSet(children.begin(), children.end()) {
+        for (ProcessId id = 0; id < this->communicator->getNumberOfProcesses(); ++id) {
+            peers.push_back({id});
+            if (id != COORDINATOR_ID and id != this->communicator->getProcessId()) {
+                cohortPeers.insert(id);
+            }
+        }
     }
 
+    /**
+     * Takes part in the configured number of 3PC instances, demultiplexing the coordinator's messages by transaction id.
+     */
     void run() override {
         this->sleep();
         this->crashIfSignalled();
+        if (this->isRecovering()) {
+            recover();
+        }
+        awaitNextTransaction();
         while (not this->terminate) {
-            switch (this->state) {
-                case Q: {
-                    this->logWithState("Entered state Q");
-                    auto potentialPacket = this->getTaggedCommunicator()->receive(ROUND_TIME, this->defaultTag);
-                    if (potentialPacket.has_value()) {
-                        auto packet = potentialPacket.value();
-                        if (packet.source == COORDINATOR_ID and packet.messageType == MessageType::CAN_COMMIT) {
-                            this->logWithState("Received CAN_COMMIT request from the coordinator");
-                            this->communicator->send(MessageType::COMMIT_AGREE, "Y", COORDINATOR_ID);
-                            this->logWithState("Sent COMMIT_AGREE to coordinator's CAN_COMMIT request");
-                            this->state = W;
-                            break;
-                        }
-                        this->logUnexpectedPacket(packet);
-                    } else {
-                        this->logWithState("There was a timeout when receiving CAN_COMMIT");
-                        this->communicator->send(MessageType::DO_ABORT, "", COORDINATOR_ID);
-                        this->logWithState("Sent DO_ABORT to coordinator");
-                        this->state = A;
+            const bool available = this->communicator->now() < availableUntil;
+            if (this->transactions.empty() and not available) {
+                this->commitLog();
+                this->flushOutbox();
+                this->logSummary();
+                this->terminate = true;
+                return;
+            }
+            auto potentialPacket = this->receiveUntilNextDeadline(available ? std::optional(availableUntil) : std::nullopt);
+            if (potentialPacket.has_value()) {
+                handlePacket(potentialPacket.value());
+            }
+            expectCollectiveRequest();
+            this->transactions.forEachExpired(this->communicator->now(), [&](Transaction& transaction) {
+                if (not this->terminate) {
+                    handleTimeout(transaction);
+                }
+            });
+            if (this->isSuspected(parent[0])) {
+                giveUpOnCoordinator();
+            }
+            this->crashIfSignalled();
+        }
+    }
+
+private:
+
+    /**
+     * Creates the entry of the next transaction the coordinator is going to start with this process, waiting in Q for
+     * its CAN_COMMIT: the first one from nextTransactionId on which touches the process and is not part of a batch it
+     * knows of. Requests which overtake each other create entries of their own (see findOrCreate), so this entry only
+     * makes the process wait for its next transaction, and give up on it after a timeout. It is dropped once a batch
+     * started since turns out to contain it.
+     */
+    void awaitNextTransaction() {
+        const unsigned transactionCount = Configuration::get().transactions;
+        TransactionId next = nextTransactionId;
+        while ((next = this->participantSets.nextInvolving(next, transactionCount, this->communicator->getProcessId())) < transactionCount) {
+            auto batch = findKnownBatch(next);
+            if (batch == knownBatches.end()) {
+                break;
+            }
+            next = batch->second;
+        }
+        if (next == awaitedTransactionId and this->transactions.find(next) != nullptr) {
+            return;
+        }
+        Transaction* previous = this->transactions.find(awaitedTransactionId);
+        if (previous != nullptr and previous->state == Q) {
+            this->transactions.erase(awaitedTransactionId);
+        }
+        awaitedTransactionId = next;
+        if (awaitedTransactionId < transactionCount and this->transactions.find(awaitedTransactionId) == nullptr) {
+            Transaction& transaction = this->transactions.insert(awaitedTransactionId);
+            // Replaced once the CAN_COMMIT arrives, but counts if the transaction is decided without one
+            transaction.startTime = this->communicator->now();
+            transaction.phaseStartTime = transaction.startTime;
+            this->logWithState(transaction, "Entered state Q");
+            postponeAwaitedDeadline(transaction);
+            expectCollectiveRequest();
+        }
+    }
+
+    /**
+     * Gives the coordinator time for the awaited transaction and for the ones before it which do not touch this process.
+     */
+    void postponeAwaitedDeadline(Transaction& transaction) {
+        const auto transactionsAhead = transaction.id - nextTransactionId + 1;
+        this->transactions.setDeadline(transaction, this->communicator->now() + getPhaseTimeout() * transactionsAhead);
+    }
+
+    /**
+     * @return The transaction the packet is about, nullptr if there is none. A packet which can start a transaction this
+     * process has not decided yet creates its entry in Q, whether or not it is the awaited one: a CAN_COMMIT or DO_ABORT
+     * of the coordinator, or a STATE_REQUEST or STATE_REPORT of a cohort member.
+     */
+    Transaction* findOrCreate(const Packet& packet) {
+        Transaction* transaction = this->transactions.find(packet.transactionId);
+        const bool startsTransaction = packet.messageType == MessageType::CAN_COMMIT or packet.messageType == MessageType::DO_ABORT
+                                       or packet.messageType == MessageType::STATE_REQUEST or packet.messageType == MessageType::STATE_REPORT;
+        if (transaction != nullptr or not startsTransaction or packet.transactionId >= Configuration::get().transactions
+            or isDecided(packet.transactionId)) {
+            return transaction;
+        }
+        transaction = &this->transactions.insert(packet.transactionId);
+        transaction->startTime = this->communicator->now();
+        transaction->phaseStartTime = transaction->startTime;
+        this->logWithState(*transaction, "Entered state Q");
+        postponeDeadline(*transaction);
+        return transaction;
+    }
+
+    /**
+     * @return Whether the process decided the transaction, given that it touches the process
+     */
+    bool isDecided(TransactionId id) {
+        if (this->transactions.find(id) != nullptr) {
+            return false;
+        }
+        if (knownBatches.count(id) > 0) {
+            return true;
+        }
+        // Every transaction touching the process before nextTransactionId belongs to a decided batch
+        return this->participantSets.nextInvolving(id, Configuration::get().transactions, this->communicator->getProcessId()) < nextTransactionId;
+    }
+
+    /**
+     * @return The known batch containing the transaction, if any
+     */
+    std::map<TransactionId, TransactionId>::const_iterator findKnownBatch(TransactionId id) const {
+        auto batch = knownBatches.upper_bound(id);
+        if (batch == knownBatches.begin()) {
+            return knownBatches.end();
+        }
+        --batch;
+        return batch->second > id ? batch : knownBatches.end();
+    }
+
+    /**
+     * Records the decided batch and moves nextTransactionId past every batch decided without a gap before it.
+     */
+    void recordDecidedBatch(TransactionId id, TransactionId end) {
+        const unsigned transactionCount = Configuration::get().transactions;
+        if (end > nextTransactionId) {
+            knownBatches[id] = end;
+        }
+        while (true) {
+            nextTransactionId = this->participantSets.nextInvolving(nextTransactionId, transactionCount, this->communicator->getProcessId());
+            auto batch = findKnownBatch(nextTransactionId);
+            if (batch == knownBatches.end() or this->transactions.find(batch->first) != nullptr) {
+                break;
+            }
+            nextTransactionId = batch->second;
+        }
+        while (not knownBatches.empty() and knownBatches.begin()->second <= nextTransactionId) {
+            knownBatches.erase(knownBatches.begin());
+        }
+    }
+
+    /**
+     * Starts waiting for the CAN_COMMIT of the awaited transaction on its collective channel, unless the channel is
+     * retired. If an earlier transaction still occupies the channel, this has to be retried once it finishes.
+     */
+    void expectCollectiveRequest() {
+        if (this->collectiveVoting == nullptr) {
+            return;
+        }
+        Transaction* transaction = this->transactions.find(awaitedTransactionId);
+        if (transaction != nullptr and transaction->state == Q and not transaction->collective
+            and this->collectiveVoting->tryAcquire(transaction->id)) {
+            transaction->collective = true;
+            this->collectiveVoting->expectBroadcast(transaction->id);
+        }
+    }
+
+    /**
+     * Sends a response to the coordinator, either point-to-point or as a contribution to the collective gathering,
+     * in which case the next request of the coordinator is awaited right away.
+     */
+    void respondToCoordinator(Transaction& transaction, MessageType messageType, const std::string& message) {
+        if (not transaction.collective) {
+            this->sendToPeers(transaction.id, messageType, message);
+            return;
+        }
+        this->sendRecorded(parent, [&] { return this->collectiveVoting->respond(transaction.id, messageType, message); });
+        this->collectiveVoting->expectBroadcast(transaction.id);
+    }
+
+    void handlePacket(const Packet& packet) {
+        if (isFromRestartedCoordinator(packet)) {
+            handleTerminationPacket(packet);
+            return;
+        }
+        if (packet.source != parent[0]) {
+            if (childSet.contains(packet.source)) {
+                handleSubtreeResponse(packet);
+                return;
+            }
+            if (Configuration::get().terminationProtocol) {
+                handleTerminationPacket(packet);
+                return;
+            }
+            this->logUnexpectedPacket(packet);
+            return;
+        }
+        relayToSubtree(packet);
+        // Any message from the coordinator proves it is alive, so the transaction waiting for CAN_COMMIT keeps waiting
+        Transaction* awaitedTransaction = this->transactions.find(awaitedTransactionId);
+        if (awaitedTransaction != nullptr and awaitedTransaction->state == Q) {
+            postponeAwaitedDeadline(*awaitedTransaction);
+        }
+        Transaction* transaction = findOrCreate(packet);
+        if (transaction == nullptr) {
+            if (packet.messageType == MessageType::CAN_COMMIT and packet.transactionId < Configuration::get().transactions
+                and isDecided(packet.transactionId)) {
+                // The process gave up on the transaction before its request arrived, so it votes against it
+                this->sendDurably(parent, [this, id = packet.transactionId] {
+                    return this->communicator->send(id, MessageType::DO_ABORT, "", parent[0]);
+                });
+                Logger::log(util::concat("Sent DO_ABORT to the CAN_COMMIT of the transaction ", packet.transactionId,
+                                         ", which this process aborted already"));
+                return;
+            }
+            answerWithDecision(packet);
+            return;
+        }
+        this->recordMessageWait(*transaction, packet.messageType);
+        if (transaction->state != Q) {
+            // From the response of this process until the coordinator's next request, so it covers the slowest cohort member
+            this->roundTripTimes.record(static_cast<std::size_t>(parent[0]), this->communicator->now() - transaction->phaseStartTime);
+        }
+        switch (transaction->state) {
+            case Q: {
+                if (packet.messageType == MessageType::CAN_COMMIT) {
+                    transaction->startTime = this->communicator->now();
+                    applyBatchDescription(*transaction, packet.message);
+                    this->logWithState(*transaction, "Received CAN_COMMIT request from the coordinator", MessageType::CAN_COMMIT);
+                    // The votes on a batch are a mask of the transactions this process agrees to, currently all of them
+                    if (children.empty()) {
+                        respondToCoordinator(*transaction, MessageType::COMMIT_AGREE,
+                                             transaction->batchSize == 1 ? "Y" : formatBatchMask(transaction->batchMask));
+                        this->logWithState(*transaction, "Sent COMMIT_AGREE to coordinator's CAN_COMMIT request", MessageType::COMMIT_AGREE);
                     }
-                    break;
+                    knownBatches[transaction->id] = transaction->id + transaction->batchSize;
+                    this->enterState(*transaction, W);
+                    awaitSubtree(*transaction);
+                    awaitNextTransaction();
+                    return;
+                } else if (packet.messageType == MessageType::DO_ABORT) {
+                    // E.g. after a restart of the coordinator, which aborts what it started before without asking again
+                    this->logWithState(*transaction, "Received DO_ABORT instead of CAN_COMMIT from the coordinator", MessageType::DO_ABORT);
+                    abortAwaitedTransaction(*transaction);
+                    return;
                 }
-                case W: {
-                    this->logWithState("Entered state W");
-                    auto potentialPacket = this->getTaggedCommunicator()->receive(ROUND_TIME, this->defaultTag);
-                    if (potentialPacket.has_value()) {
-                        auto packet = potentialPacket.value();
-                        if (packet.source == COORDINATOR_ID) {
-                            if (packet.messageType == MessageType::PREPARE_COMMIT) {
-                                this->logWithState("Received PREPARE_COMMIT request from the coordinator");
-                                this->communicator->send(MessageType::COMMIT_ACK, "", COORDINATOR_ID);
-                                this->logWithState("Sent COMMIT_ACK to coordinator's PREPARE_COMMIT request");
-                                this->state = P;
-                                break;
-                            } else if (packet.messageType == MessageType::DO_ABORT) {
-                                this->logWithState("Received DO_ABORT request from the coordinator");
-                                this->state = A;
-                                break;
-                            }
-                        }
-                        this->logUnexpectedPacket(packet);
-                    } else {
-                        this->logWithState("There was a timeout when receiving PREPARE_COMMIT or DO_ABORT");
-                        this->state = A;
+                break;
+            }
+            case W: {
+                if (packet.messageType == MessageType::PREPARE_COMMIT) {
+                    applyBatchDescription(*transaction, packet.message);
+                    this->logWithState(*transaction, "Received PREPARE_COMMIT request from the coordinator", MessageType::PREPARE_COMMIT);
+                    if (children.empty()) {
+                        respondToCoordinator(*transaction, MessageType::COMMIT_ACK, "");
+                        this->logWithState(*transaction, "Sent COMMIT_ACK to coordinator's PREPARE_COMMIT request", MessageType::COMMIT_ACK);
                     }
+                    this->enterState(*transaction, P);
+                    awaitSubtree(*transaction);
+                    return;
+                } else if (packet.messageType == MessageType::DO_ABORT) {
+                    this->logWithState(*transaction, "Received DO_ABORT request from the coordinator", MessageType::DO_ABORT);
+                    decide(*transaction, A);
+                    return;
+                }
+                break;
+            }
+            case P: {
+                if (packet.messageType == MessageType::DO_COMMIT) {
+                    this->logWithState(*transaction, "Received DO_COMMIT from the coordinator", MessageType::DO_COMMIT);
+                    decide(*transaction, C);
+                    return;
+                } else if (packet.messageType == MessageType::DO_ABORT) {
+                    this->logWithState(*transaction, "Received DO_ABORT from the coordinator", MessageType::DO_ABORT);
+                    decide(*transaction, A);
+                    return;
+                }
+                break;
+            }
+            default: {
+                break;
+            }
+        }
+        this->logUnexpectedPacket(*transaction, packet);
+    }
+
+    /**
+     * @return Whether the packet belongs to a restarted coordinator gathering the states of the cohort, which it
+     * addresses directly and like a backup coordinator
+     */
+    bool isFromRestartedCoordinator(const Packet& packet) {
+        if (packet.source != COORDINATOR_ID) {
+            return false;
+        }
+        const Transaction* transaction = this->transactions.find(packet.transactionId);
+        return packet.messageType == MessageType::STATE_REQUEST or (transaction != nullptr and transaction->backup == COORDINATOR_ID);
+    }
+
+    void handleTimeout(Transaction& transaction) {
+        this->metrics.timeouts.fetch_add(1, std::memory_order_relaxed);
+        if (transaction.subtreePending) {
+            this->logWithState(transaction, "There was a timeout - some members of the subtree did not respond");
+            respondForSubtree(transaction, MessageType::DO_ABORT, "", "Sent DO_ABORT to the parent because of a missing response of the subtree");
+            return;
+        }
+        if (transaction.backup == this->communicator->getProcessId()) {
+            this->logWithState(transaction, "There was a timeout - some cohort members did not respond to the backup coordinator");
+            if (transaction.backupPrepared) {
+                announceAsBackup(transaction, MessageType::DO_COMMIT, C);
+            } else {
+                decideAsBackup(transaction);
+            }
+            return;
+        }
+        if (transaction.backup == COORDINATOR_ID and not Configuration::get().terminationProtocol) {
+            // Without the termination protocol nobody stands in for a restarted coordinator which asked for the state
+            transaction.backup = -1;
+        }
+        if (transaction.backup >= 0) {
+            this->logWithState(transaction, util::concat("There was a timeout - gave up on the backup coordinator ", transaction.backup));
+            // Once the cohort members of lower rank are given up on, this process is next
+            askBackup(transaction, std::min(nextParticipant(transaction, transaction.backup), this->communicator->getProcessId()));
+            return;
+        }
+        giveUp(transaction, "There was a timeout");
+    }
+
+    /**
+     * Treats every transaction as timed out once the failure detector suspects the coordinator, instead of waiting
+     * for their deadlines.
+     */
+    void giveUpOnCoordinator() {
+        std::vector<TransactionId> ids;
+        this->transactions.forEach([&](const Transaction& transaction) { ids.push_back(transaction.id); });
+        for (TransactionId id : ids) {
+            Transaction* transaction = this->transactions.find(id);
+            if (transaction == nullptr or transaction->backup >= 0 or this->terminate) {
+                continue;
+            }
+            this->metrics.suspicions.fetch_add(1, std::memory_order_relaxed);
+            giveUp(*transaction, "The coordinator is suspected to have crashed");
+        }
+    }
+
+    /**
+     * Decides the transactions the write-ahead log has in flight as if they had timed out, as the messages of
+     * the coordinator they were waiting for are lost, and continues after the last transaction the process took part in.
+     * The decisions of the log are kept for the restarted coordinator, which asks for the ones it had prepared, so
+     * the process stays up for a while even if it has no transactions left.
+     */
+    void recover() {
+        nextTransactionId = this->writeAheadLog->getRecovery().nextTransactionId;
+        decisions = this->writeAheadLog->getRecovery().decided;
+        availableUntil = this->communicator->now() + 2 * getPhaseTimeout();
+        for (TransactionId id : this->restoreTransactions()) {
+            Transaction* transaction = this->transactions.find(id);
+            if (this->terminate) {
+                return;
+            }
+            giveUp(*transaction, "Lost the messages of the coordinator in a restart");
+        }
+    }
+
+    /**
+     * Decides the transaction without the coordinator: alone, e.g. committing it if it was already prepared, or with
+     * the termination protocol together with the rest of the cohort.
+     * @param cause Why the coordinator's next message is not awaited any longer
+     */
+    void giveUp(Transaction& transaction, const std::string& cause) {
+        this->retireCollectiveChannel(transaction);
+        transaction.subtreePending = false;
+        switch (transaction.state) {
+            case Q: {
+                this->logWithState(transaction, cause + " when receiving CAN_COMMIT");
+                this->sendDurably(parent, [this, id = transaction.id] {
+                    return this->communicator->send(id, MessageType::DO_ABORT, "", parent[0]);
+                });
+                this->logWithState(transaction, "Sent DO_ABORT to coordinator", MessageType::DO_ABORT);
+                if (not this->isSuspected(parent[0])) {
+                    // The coordinator may just be slow, so only this transaction is given up on
+                    decide(transaction, A);
+                    awaitNextTransaction();
                     break;
                 }
-                case P: {
-                    this->logWithState("Entered state P");
-                    auto potentialPacket = this->getTaggedCommunicator()->receive(ROUND_TIME, this->defaultTag);
-                    if (potentialPacket.has_value()) {
-                        auto packet = potentialPacket.value();
-                        if (packet.source == COORDINATOR_ID) {
-                            if (packet.messageType == MessageType::DO_COMMIT) {
-                                this->logWithState("Received DO_COMMIT from the coordinator");
-                                this->state = C;
-                                break;
-                            } else if (packet.messageType == MessageType::DO_ABORT) {
-                                this->logWithState("Received DO_ABORT from the coordinator");
-                                this->state = A;
-                                break;
-                            }
-                        }
-                        this->logUnexpectedPacket(packet);
-                    } else {
-                        this->logWithState("There was a timeout when receiving DO_COMMIT or DO_ABORT");
-                        this->state = C;
+                // The coordinator is considered dead, so there is no point in waiting for the remaining transactions
+                unsigned remainingTransactions = Configuration::get().transactions - nextTransactionId - 1;
+                if (remainingTransactions > 0) {
+                    this->logWithState(transaction, util::concat("Gave up waiting for the remaining ", remainingTransactions, " transaction(s)"));
+                }
+                nextTransactionId = Configuration::get().transactions;
+                decide(transaction, A);
+                break;
+            }
+            case W: {
+                this->logWithState(transaction, cause + " when receiving PREPARE_COMMIT or DO_ABORT");
+                if (Configuration::get().terminationProtocol) {
+                    startTermination(transaction);
+                    break;
+                }
+                decide(transaction, A);
+                break;
+            }
+            case P: {
+                this->logWithState(transaction, cause + " when receiving DO_COMMIT or DO_ABORT");
+                if (Configuration::get().terminationProtocol) {
+                    startTermination(transaction);
+                    break;
+                }
+                decide(transaction, C);
+                break;
+            }
+            default: {
+                break;
+            }
+        }
+    }
+
+    /**
+     * Moves the transaction to its final state, which the process remembers for a while to tell cohort members
+     * which are still terminating the transaction.
+     */
+    void decide(Transaction& transaction, State decision) {
+        if (transaction.backup >= 0) {
+            this->metrics.terminationDuration().record(this->communicator->now() - transaction.terminationStartTime);
+            this->metrics.terminations.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (Configuration::get().terminationProtocol or this->writeAheadLog != nullptr) {
+            decisions[transaction.id] = decision;
+            if (decisions.size() > DECISION_HISTORY) {
+                decisions.erase(decisions.begin());
+            }
+        }
+        const TransactionId id = transaction.id;
+        const TransactionId end = transaction.id + transaction.batchSize;
+        this->enterState(transaction, decision);
+        recordDecidedBatch(id, end);
+    }
+
+    /**
+     * Aborts the transaction waiting in Q for its CAN_COMMIT and starts waiting for the next one.
+     */
+    void abortAwaitedTransaction(Transaction& transaction) {
+        transaction.startTime = this->communicator->now();
+        decide(transaction, A);
+        awaitNextTransaction();
+    }
+
+    /**
+     * Starts the termination protocol of a transaction the coordinator was given up on. The cohort member of the lowest
+     * rank the transaction touches becomes the backup coordinator, the next one whenever the current one does not
+     * respond in time.
+     */
+    void startTermination(Transaction& transaction) {
+        transaction.terminationStartTime = this->communicator->now();
+        askBackup(transaction, nextParticipant(transaction, -1));
+    }
+
+    /**
+     * @return The first cohort member after the given rank which the transaction touches, at the latest this process
+     */
+    ProcessId nextParticipant(const Transaction& transaction, ProcessId after) {
+        const auto& others = getOtherParticipants(transaction);
+        const ProcessId self = this->communicator->getProcessId();
+        ProcessId next = after + 1;
+        while (next != self and (next == COORDINATOR_ID or not others.contains(next))) {
+            ++next;
+        }
+        return next;
+    }
+
+    /**
+     * @return The cohort members other than this process which the transaction touches, and which the backup
+     * coordinator addresses
+     */
+    const RankSet& getOtherParticipants(const Transaction& transaction) {
+        const auto* participants = this->participantSets.get(transaction.id, transaction.batchSize);
+        return participants != nullptr ? *participants : cohortPeers;
+    }
+
+    /**
+     * Reports the state of the transaction to the given backup coordinator, or takes over if it is this process.
+     */
+    void askBackup(Transaction& transaction, ProcessId backup) {
+        if (backup == this->communicator->getProcessId()) {
+            takeOver(transaction);
+            return;
+        }
+        transaction.backup = backup;
+        sendState(transaction.id, transaction.state, backup, describeBatch(transaction));
+        this->logWithState(transaction, util::concat("Sent STATE_REPORT to the backup coordinator ", backup), MessageType::STATE_REPORT);
+        awaitBackup(transaction);
+    }
+
+    /**
+     * Becomes the backup coordinator of the transaction and asks the rest of the cohort for their states.
+     */
+    void takeOver(Transaction& transaction) {
+        if (transaction.backup < 0) {
+            transaction.terminationStartTime = this->communicator->now();
+            this->retireCollectiveChannel(transaction);
+        }
+        transaction.backup = this->communicator->getProcessId();
+        transaction.reportedStates = 0;
+        transaction.backupPrepared = false;
+        transaction.responders.clear();
+        const auto& others = getOtherParticipants(transaction);
+        if (others.empty()) {
+            decideAsBackup(transaction);
+            return;
+        }
+        this->sendDurably(others, [this, &others, id = transaction.id, batch = describeBatch(transaction)] {
+            return this->communicator->send(id, MessageType::STATE_REQUEST, batch, others);
+        });
+        this->logWithState(transaction, "Sent STATE_REQUEST to the cohort as the backup coordinator", MessageType::STATE_REQUEST);
+        this->transactions.setDeadline(transaction, this->communicator->now() + getPhaseTimeout());
+    }
+
+    /**
+     * Decides the transaction from the states the cohort reported to this process as the backup coordinator. A cohort
+     * member in P may already have committed, so then the others are moved to P before everybody commits, which keeps
+     * the outcome the same if the backup crashes in turn. Without any prepared cohort member nobody may have committed
+     * yet, and the transaction is aborted.
+     */
+    void decideAsBackup(Transaction& transaction) {
+        const unsigned states = transaction.reportedStates | stateBit(transaction.state);
+        if (states & stateBit(C)) {
+            announceAsBackup(transaction, MessageType::DO_COMMIT, C);
+        } else if (states & stateBit(A)) {
+            announceAsBackup(transaction, MessageType::DO_ABORT, A);
+        } else if (states & stateBit(P)) {
+            const auto& others = getOtherParticipants(transaction);
+            this->sendDurably(others, [this, &others, id = transaction.id, batch = describeBatch(transaction)] {
+                return this->communicator->send(id, MessageType::PREPARE_COMMIT, batch, others);
+            });
+            this->logWithState(transaction, "Sent PREPARE_COMMIT to the cohort as the backup coordinator", MessageType::PREPARE_COMMIT);
+            this->enterState(transaction, P);
+            transaction.backupPrepared = true;
+            if (others.empty()) {
+                announceAsBackup(transaction, MessageType::DO_COMMIT, C);
+            }
+        } else {
+            announceAsBackup(transaction, MessageType::DO_ABORT, A);
+        }
+    }
+
+    void announceAsBackup(Transaction& transaction, MessageType messageType, State decision) {
+        const auto& others = getOtherParticipants(transaction);
+        this->sendDurably(others, [this, &others, id = transaction.id, messageType] {
+            return this->communicator->send(id, messageType, "", others);
+        });
+        this->logWithState(transaction, util::concat("Sent ", messageType, " to the cohort as the backup coordinator"), messageType);
+        decide(transaction, decision);
+    }
+
+    /**
+     * Handles the messages the cohort members exchange in the termination protocol.
+     */
+    void handleTerminationPacket(const Packet& packet) {
+        Transaction* transaction = findOrCreate(packet);
+        if (transaction != nullptr and transaction->state == Q
+            and (packet.messageType == MessageType::STATE_REQUEST or packet.messageType == MessageType::STATE_REPORT)) {
+            // Without the vote of this process nobody can have prepared the transaction
+            applyBatchDescription(*transaction, packet.messageType == MessageType::STATE_REPORT ? reportedBatch(packet.message) : packet.message);
+            this->logWithState(*transaction, util::concat("Received ", packet.messageType, " from the process ", packet.source,
+                                                          " instead of CAN_COMMIT from the coordinator"), packet.messageType);
+            abortAwaitedTransaction(*transaction);
+            transaction = nullptr;
+        }
+        if (transaction == nullptr) {
+            answerWithDecision(packet);
+            return;
+        }
+        this->logWithState(*transaction, util::concat("Received ", packet.messageType, " from the process ", packet.source), packet.messageType);
+        const ProcessId self = this->communicator->getProcessId();
+        switch (packet.messageType) {
+            case MessageType::STATE_REQUEST: {
+                // Unless the state was already reported to this backup when giving up on the coordinator
+                if (transaction->backup != packet.source) {
+                    sendState(transaction->id, transaction->state, packet.source, describeBatch(*transaction));
+                }
+                // Of two backups the one of the lower rank wins, the other one still learns the state of this process
+                if (transaction->backup < 0 or packet.source < transaction->backup) {
+                    if (transaction->backup < 0) {
+                        transaction->terminationStartTime = this->communicator->now();
+                        this->retireCollectiveChannel(*transaction);
                     }
+                    transaction->backup = packet.source;
+                    transaction->backupPrepared = false;
+                    awaitBackup(*transaction);
+                }
+                return;
+            }
+            case MessageType::STATE_REPORT: {
+                auto state = parseReportedState(packet.message);
+                if (not state.has_value()) {
                     break;
                 }
-                case A: {
-                    this->logWithState("Entered state A - aborted the transaction!");
-                    this->terminate = true;
+                if (transaction->backup == COORDINATOR_ID) {
+                    // Meant for this process as the backup before the restarted coordinator took over
+                    this->logWithState(*transaction, "Ignored the STATE_REPORT, as the restarted coordinator decides the transaction");
                     return;
                 }
-                case C: {
-                    this->logWithState("Entered state C - committed the transaction!");
-                    this->terminate = true;
+                // A prepared cohort member knows which transactions of a batch are left to commit
+                applyBatchDescription(*transaction, reportedBatch(packet.message));
+                if (transaction->backup != self) {
+                    takeOver(*transaction);
+                }
+                if (this->terminate or this->transactions.find(packet.transactionId) == nullptr) {
                     return;
                 }
+                if (transaction->backupPrepared) {
+                    // Joins late, so it still has to be moved to P
+                    this->sendDurably(peers[static_cast<std::size_t>(packet.source)],
+                                      [this, id = transaction->id, source = packet.source, batch = describeBatch(*transaction)] {
+                        return this->communicator->send(id, MessageType::PREPARE_COMMIT, batch, source);
+                    });
+                    return;
+                }
+                transaction->reportedStates |= stateBit(state.value());
+                transaction->responders.insert(packet.source);
+                if (transaction->responders.size() == getOtherParticipants(*transaction).size()) {
+                    decideAsBackup(*transaction);
+                }
+                return;
+            }
+            case MessageType::COMMIT_ACK: {
+                if (transaction->backup != self or not transaction->backupPrepared) {
+                    break;
+                }
+                transaction->responders.insert(packet.source);
+                if (transaction->responders.size() == getOtherParticipants(*transaction).size()) {
+                    announceAsBackup(*transaction, MessageType::DO_COMMIT, C);
+                }
+                return;
+            }
+            case MessageType::PREPARE_COMMIT: {
+                // A backup replaced by the restarted coordinator may still be moving the cohort to P
+                if ((transaction->state != W and transaction->state != P) or transaction->backup == COORDINATOR_ID) {
+                    break;
+                }
+                transaction->backup = packet.source;
+                applyBatchDescription(*transaction, packet.message);
+                this->sendDurably(peers[static_cast<std::size_t>(packet.source)], [this, id = transaction->id, source = packet.source] {
+                    return this->communicator->send(id, MessageType::COMMIT_ACK, "", source);
+                });
+                this->logWithState(*transaction, "Sent COMMIT_ACK to the backup coordinator", MessageType::COMMIT_ACK);
+                this->enterState(*transaction, P);
+                if (not this->terminate) {
+                    awaitBackup(*transaction);
+                }
+                return;
+            }
+            case MessageType::DO_COMMIT: {
+                decide(*transaction, C);
+                return;
+            }
+            case MessageType::DO_ABORT: {
+                decide(*transaction, A);
+                return;
+            }
+            default: {
+                break;
             }
-            this->sleep();
-            this->crashIfSignalled();
         }
+        this->logUnexpectedPacket(*transaction, packet);
     }
+
+    /**
+     * Answers a cohort member terminating a transaction this process already decided: a backup coordinator gets
+     * the final state reported, a cohort member asking this process to take over gets the decision right away.
+     * The decision itself arriving once more, e.g. from the restarted coordinator, needs no answer.
+     */
+    void answerWithDecision(const Packet& packet) {
+        auto decision = decisions.find(packet.transactionId);
+        if (decision != decisions.end() and (packet.messageType == MessageType::DO_COMMIT or packet.messageType == MessageType::DO_ABORT)) {
+            Logger::log(util::concat("Ignored ", packet.messageType, " of the transaction ", packet.transactionId,
+                                     ", which this process decided as ", decision->second, " already"));
+            return;
+        }
+        if (decision == decisions.end()
+            or (packet.messageType != MessageType::STATE_REQUEST and packet.messageType != MessageType::STATE_REPORT)) {
+            this->logUnexpectedPacket(packet);
+            return;
+        }
+        if (packet.messageType == MessageType::STATE_REQUEST) {
+            sendState(packet.transactionId, decision->second, packet.source);
+            return;
+        }
+        const MessageType messageType = decision->second == C ? MessageType::DO_COMMIT : MessageType::DO_ABORT;
+        this->sendDurably(peers[static_cast<std::size_t>(packet.source)], [this, id = packet.transactionId, messageType, source = packet.source] {
+            return this->communicator->send(id, messageType, "", source);
+        });
+        Logger::log(util::concat("[", this->communicator->getProcessId(), "] Sent ", messageType, " of the decided transaction ",
+                                 packet.transactionId, " to the process ", packet.source));
+    }
+
+    /**
+     * Reports a state, followed by the description of the batch if there is one, e.g. "P 16 fff7".
+     */
+    void sendState(TransactionId transactionId, State state, ProcessId recipient, const std::string& batch = "") {
+        std::string report = batch.empty() ? stateString.at(state) : stateString.at(state) + " " + batch;
+        this->sendDurably(peers[static_cast<std::size_t>(recipient)], [this, transactionId, report = std::move(report), recipient] {
+            return this->communicator->send(transactionId, MessageType::STATE_REPORT, report, recipient);
+        });
+    }
+
+    static std::string_view reportedBatch(std::string_view report) {
+        const auto separator = report.find(' ');
+        return separator == std::string_view::npos ? std::string_view() : report.substr(separator + 1);
+    }
+
+    /**
+     * Gives the backup coordinator time to gather the states of the cohort and to move it to P.
+     */
+    void awaitBackup(Transaction& transaction) {
+        this->transactions.setDeadline(transaction, this->communicator->now() + 2 * getPhaseTimeout());
+    }
+
+    /**
+     * Passes a request of the parent on to the children, which relays it further down the tree.
+     */
+    void relayToSubtree(const Packet& packet) {
+        if (children.empty() or (packet.messageType != MessageType::CAN_COMMIT and packet.messageType != MessageType::PREPARE_COMMIT
+                                 and packet.messageType != MessageType::DO_COMMIT and packet.messageType != MessageType::DO_ABORT)) {
+            return;
+        }
+        this->sendDurably(childSet, [this, id = packet.transactionId, messageType = packet.messageType, message = std::string(packet.message)] {
+            return this->getTaggedCommunicator()->send(id, messageType, message, childSet, this->defaultTag);
+        });
+        Logger::log(util::concat("Relayed ", packet.messageType, " of the transaction ", packet.transactionId, " to the subtree"));
+    }
+
+    /**
+     * Makes a relay wait for the responses of its children to the request of the current phase, which it aggregates
+     * into a response of its own.
+     */
+    void awaitSubtree(Transaction& transaction) {
+        if (children.empty() or this->terminate) {
+            return;
+        }
+        transaction.subtreePending = true;
+        this->transactions.setDeadline(transaction, this->communicator->now() + getSubtreeTimeout());
+    }
+
+    /**
+     * Records the response of a child in the current phase. The relay responds for its whole subtree as soon as the
+     * first response is not the expected one, or once every child responded.
+     */
+    void handleSubtreeResponse(const Packet& packet) {
+        Transaction* transaction = this->transactions.find(packet.transactionId);
+        if (transaction == nullptr or not transaction->subtreePending) {
+            // Responses still on their way when the relay responded without them
+            Logger::log(util::concat("Ignored a late response of the subtree: ", this->printPacket(packet)));
+            return;
+        }
+        if (not transaction->responders.insert(packet.source)) {
+            this->logUnexpectedPacket(*transaction, packet);
+            return;
+        }
+        this->recordMessageWait(*transaction, packet.messageType);
+        const bool voting = transaction->state == W;
+        if (packet.messageType != (voting ? MessageType::COMMIT_AGREE : MessageType::COMMIT_ACK)) {
+            transaction->responsesAsExpected = false;
+        } else if (voting and transaction->batchSize > 1) {
+            transaction->batchMask &= parseBatchMask(packet.message).value_or(0);
+            transaction->responsesAsExpected = transaction->batchMask != 0;
+        } else if (packet.message != (voting ? "Y" : "")) {
+            transaction->responsesAsExpected = false;
+        }
+        if (not transaction->responsesAsExpected) {
+            respondForSubtree(*transaction, MessageType::DO_ABORT, "", "Sent DO_ABORT to the parent because a member of the subtree did not agree");
+            return;
+        }
+        this->roundTripTimes.record(static_cast<std::size_t>(packet.source), this->communicator->now() - transaction->phaseStartTime);
+        if (transaction->responders.size() < children.size()) {
+            return;
+        }
+        this->metrics.gatherDuration(transaction->state).record(this->communicator->now() - transaction->phaseStartTime);
+        if (voting) {
+            respondForSubtree(*transaction, MessageType::COMMIT_AGREE,
+                              transaction->batchSize == 1 ? "Y" : formatBatchMask(transaction->batchMask),
+                              "Sent COMMIT_AGREE of the whole subtree to the parent");
+        } else {
+            respondForSubtree(*transaction, MessageType::COMMIT_ACK, "", "Sent COMMIT_ACK of the whole subtree to the parent");
+        }
+    }
+
+    void respondForSubtree(Transaction& transaction, MessageType messageType, const std::string& message, std::string_view logMessage) {
+        transaction.subtreePending = false;
+        respondToCoordinator(transaction, messageType, message);
+        this->logWithState(transaction, logMessage, messageType);
+        postponeDeadline(transaction);
+    }
+
+    std::chrono::steady_clock::duration getPhaseTimeout() override {
+        return this->getTimeoutFor(parent);
+    }
+
+    /**
+     * @return How long a relay waits for the responses of its subtree: the subtree timeout for every level below it, or
+     * with adaptive timeouts a timeout derived from the round-trip times to its children
+     */
+    std::chrono::steady_clock::duration getSubtreeTimeout() {
+        if (Configuration::get().adaptiveTimeouts) {
+            return this->getTimeoutFor(children);
+        }
+        return std::chrono::milliseconds(Configuration::get().subtreeTimeout) * this->topology.getHeight();
+    }
+
+    void postponeDeadline(Transaction& transaction) {
+        this->transactions.setDeadline(transaction, this->communicator->now() + getPhaseTimeout());
+    }
+
+    /** Every transaction before it which touches the process is decided, apart from the ones in the table */
+    TransactionId nextTransactionId = 0;
+    /** The transaction waiting in Q for the next CAN_COMMIT to this process */
+    TransactionId awaitedTransactionId = 0;
+    /** Batches from nextTransactionId on which the process decided or takes part in, from their first transaction to the one after their last */
+    std::map<TransactionId, TransactionId> knownBatches;
+    /** The process requests come from and responses go to: the coordinator in the star, otherwise the parent in the tree */
+    std::array<ProcessId, 1> parent;
+    /** The cohort members this process relays requests to, none in the star */
+    std::vector<ProcessId> children;
+    RankSet childSet;
+    /** Every process as a single recipient, indexed by its id */
+    std::vector<std::array<ProcessId, 1>> peers;
+    /** The cohort members other than this process, which the backup coordinator addresses unless transactions touch only some */
+    RankSet cohortPeers;
+    /** Until when a restarted process answers the coordinator's questions about its decisions, even without transactions */
+    std::chrono::steady_clock::time_point availableUntil {};
+    /** Recent decisions, only kept with the termination protocol or the write-ahead log, whose peers may ask for them */
+    std::map<TransactionId, State> decisions;
 };
 
 
@@ -2,6 +2,11 @@
 #define INC_3PC_COORDINATOR_H
 
 
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <limits>
+#include <map>
 #include <logging/Logger.h>
 #include "AbstractCrashableProcess.h"
 
@@ -9,140 +14,485 @@ template <typename Tag>
 class Coordinator : public AbstractCrashableProcess<Tag> {
 public:
 
-    explicit Coordinator(std::shared_ptr<ITaggedCommunicator<Tag>> communicator, Tag defaultTag, Tag crashTag)
-        : AbstractCrashableProcess<Tag>(std::move(communicator), defaultTag, crashTag) {
+    explicit Coordinator(std::shared_ptr<ITaggedCommunicator<Tag>> communicator, Tag defaultTag, Tag crashTag, Tag heartbeatTag,
+                         std::shared_ptr<ICollectiveVoting> collectiveVoting = nullptr)
+        : AbstractCrashableProcess<Tag>(std::move(communicator), defaultTag, crashTag, heartbeatTag, std::move(collectiveVoting)),
+          children(this->topology.getChildren()) {
+        for (ProcessId id = 0; id < this->communicator->getNumberOfProcesses(); ++id) {
+            if (id != COORDINATOR_ID) {
+                cohort.insert(id);
+            }
+        }
         std::thread([&]{ processCrashInput(); }).detach();
-        this->state = Q;
     }
 
+    /**
+     * Drives the configured number of independent 3PC instances, keeping up to the configured number of them in flight.
+     */
     void run() override {
         Logger::log("Initializing 3PC");
         sleep();
         this->crashIfSignalled();
+        if (this->isRecovering()) {
+            recover();
+        }
         while (not this->terminate) {
-            switch (this->state) {
-                case Q: {
-                    this->logWithState("Entered state Q");
-                    this->communicator->sendOthers(MessageType::CAN_COMMIT, "");
-                    this->logWithState("Sent CAN_COMMIT to the cohort");
-                    this->state = W;
+            startTransactions();
+            if (abortSuspected() and not this->terminate) {
+                // New transactions can take the place of the aborted ones
+                continue;
+            }
+            if (this->terminate) {
+                break;
+            }
+            if (this->transactions.empty() and arrivals.empty()) {
+                this->commitLog();
+                this->flushOutbox();
+                this->logSummary();
+                this->terminate = true;
+                return;
+            }
+            auto potentialPacket = this->receiveUntilNextDeadline(getBatchDeadline());
+            if (potentialPacket.has_value()) {
+                handlePacket(potentialPacket.value());
+            }
+            this->transactions.forEachExpired(this->communicator->now(), [&](Transaction& transaction) {
+                if (not this->terminate) {
+                    handleTimeout(transaction);
+                }
+            });
+            this->crashIfSignalled();
+        }
+    }
+
+    void sleep() override {
+        this->sleepBetween(Configuration::get().minSleepTimeCoordinator, Configuration::get().maxSleepTimeCoordinator);
+    }
+
+private:
+
+    /**
+     * Starts 3PC instances for the transactions which arrived. Transactions arrive in a closed loop, every decided one
+     * making room for the next, and are batched: an instance starts once the batch size is reached, the oldest waiting
+     * transaction has waited for the batch window, or no more transactions are going to arrive.
+     */
+    void startTransactions() {
+        const auto& configuration = Configuration::get();
+        const auto now = this->communicator->now();
+        while (arrivedTransactions < configuration.transactions and transactionsInFlight < configuration.concurrentTransactions) {
+            arrivals.push_back(now);
+            ++arrivedTransactions;
+            ++transactionsInFlight;
+        }
+        while (not arrivals.empty() and not this->terminate) {
+            const auto batchSize = static_cast<unsigned>(std::min<std::size_t>(configuration.batchSize, arrivals.size()));
+            if (batchSize < configuration.batchSize and arrivedTransactions < configuration.transactions
+                and now < arrivals.front() + std::chrono::microseconds(configuration.batchWindow)) {
+                break;
+            }
+            bool collective = false;
+            if (this->collectiveVoting != nullptr and not this->collectiveVoting->isRetired(nextTransactionId)) {
+                // Transactions sharing a channel have to run one after another
+                if (not this->collectiveVoting->tryAcquire(nextTransactionId)) {
                     break;
                 }
-                case W: {
-                    this->logWithState("Entered state W");
-                    auto potentialPackets = receiveFromAll(ROUND_TIME);
-                    this->logWithState("Finished gathering responses for CAN_COMMIT from the cohort");
-                    if (potentialPackets.has_value()) {
-                        auto packets = potentialPackets.value();
-                        if (checkPackets(packets, MessageType::COMMIT_AGREE, "Y")) {
-                            this->logWithState("Got positive response from every cohort member for CAN_COMMIT request");
-                            this->communicator->sendOthers(MessageType::PREPARE_COMMIT, "");
-                            this->logWithState("Sent PREPARE_COMMIT to the cohort");
-                            this->state = P;
-                            break;
-                        }
-                        this->logWithState("Some cohort members did not agree to commit");
-                    } else {
-                        this->logWithState("There was a timeout - some cohort members did not sent their vote");
-                    }
-                    this->communicator->sendOthers(MessageType::DO_ABORT, "");
-                    this->logWithState("Sent DO_ABORT to the cohort because did not get agreement from every cohort member");
-                    this->state = A;
+                collective = true;
+            }
+            Transaction& transaction = this->transactions.insert(nextTransactionId);
+            nextTransactionId += batchSize;
+            transaction.startTime = this->communicator->now();
+            transaction.phaseStartTime = transaction.startTime;
+            transaction.collective = collective;
+            transaction.batchSize = batchSize;
+            transaction.batchMask = fullBatchMask(batchSize);
+            transaction.participants = this->participantSets.get(transaction.id, batchSize);
+            if (batchSize > 1) {
+                transaction.arrivalTimes.assign(arrivals.begin(), arrivals.begin() + batchSize);
+            }
+            arrivals.erase(arrivals.begin(), arrivals.begin() + batchSize);
+            this->logWithState(transaction, batchSize == 1 ? "Entered state Q" : util::concat("Entered state Q with a batch of ", batchSize, " transactions"));
+            sendToCohort(transaction, MessageType::CAN_COMMIT, describeBatch(transaction));
+            this->logWithState(transaction, "Sent CAN_COMMIT to the cohort", MessageType::CAN_COMMIT);
+            this->enterState(transaction, W);
+        }
+    }
+
+    /**
+     * @return When the oldest transaction waiting for its batch to fill up has waited for the batch window
+     */
+    std::optional<std::chrono::steady_clock::time_point> getBatchDeadline() const {
+        if (arrivals.empty()) {
+            return std::nullopt;
+        }
+        return arrivals.front() + std::chrono::microseconds(Configuration::get().batchWindow);
+    }
+
+    void decide(Transaction& transaction, State decision) {
+        this->enterState(transaction, decision);
+    }
+
+    /**
+     * Counts the transactions of the decided instance and makes room for new ones. With in-order delivery, a decision
+     * is held back until all the transactions which arrived before it are decided as well.
+     */
+    void deliver(Transaction& transaction, uint64_t committedMask) override {
+        if (not Configuration::get().inOrderDelivery or transaction.id < nextDelivery) {
+            release(transaction, committedMask);
+            return;
+        }
+        // The transaction leaves the table right after, so it is moved over
+        undelivered.emplace(transaction.id, std::make_pair(std::move(transaction), committedMask));
+        while (not undelivered.empty() and undelivered.begin()->first == nextDelivery) {
+            const auto& [heldTransaction, heldMask] = undelivered.begin()->second;
+            nextDelivery += heldTransaction.batchSize;
+            release(heldTransaction, heldMask);
+            undelivered.erase(undelivered.begin());
+        }
+    }
+
+    void release(const Transaction& transaction, uint64_t committedMask) {
+        this->recordOutcome(transaction, committedMask);
+        transactionsInFlight -= transaction.batchSize;
+    }
+
+    std::chrono::steady_clock::duration getPhaseTimeout() override {
+        return this->getTimeoutFor(children);
+    }
+
+    /**
+     * Resolves the transactions the write-ahead log has in flight and continues after the last transaction it started.
+     * Transactions still waiting for votes are aborted, as no cohort member can have prepared them. A prepared one may
+     * have been logged right before the restart, with its PREPARE_COMMIT never sent, so the cohort is asked how far it got.
+     */
+    void recover() {
+        nextTransactionId = this->writeAheadLog->getRecovery().nextTransactionId;
+        // The transactions before the restart are delivered as they are decided, as some of them may never be
+        nextDelivery = nextTransactionId;
+        arrivedTransactions = nextTransactionId;
+        const auto ids = this->restoreTransactions();
+        transactionsInFlight += ids.size();
+        for (TransactionId id : ids) {
+            Transaction* transaction = this->transactions.find(id);
+            if (this->terminate) {
+                return;
+            }
+            transaction->participants = this->participantSets.get(id, 1);
+            this->logWithState(*transaction, "Recovered the transaction from the write-ahead log");
+            if (transaction->state == P) {
+                gatherStates(*transaction);
+                continue;
+            }
+            abort(*transaction, "Sent DO_ABORT to the cohort because the transaction was interrupted by a restart");
+        }
+    }
+
+    /**
+     * Asks every cohort member the transaction touches for its state, directly instead of down the tree, as the cohort
+     * members in the termination protocol no longer relay.
+     */
+    void gatherStates(Transaction& transaction) {
+        const RankSet& members = getMembers(transaction);
+        transaction.gatheringStates = true;
+        transaction.reportedStates = 0;
+        transaction.responders.clear();
+        this->sendDurably(members, [this, &members, id = transaction.id] {
+            return this->communicator->send(id, MessageType::STATE_REQUEST, "", members);
+        });
+        this->logWithState(transaction, "Sent STATE_REQUEST to the cohort because the transaction was prepared before a restart",
+                           MessageType::STATE_REQUEST);
+        this->transactions.setDeadline(transaction, this->communicator->now() + getPhaseTimeout());
+    }
+
+    void recordState(Transaction& transaction, const Packet& packet) {
+        const auto state = packet.messageType == MessageType::STATE_REPORT ? parseReportedState(packet.message) : std::nullopt;
+        if (not state.has_value() or not getMembers(transaction).contains(packet.source) or not transaction.responders.insert(packet.source)) {
+            this->logUnexpectedPacket(transaction, packet);
+            return;
+        }
+        transaction.reportedStates |= stateBit(state.value());
+        if (transaction.responders.size() == getMembers(transaction).size()) {
+            decideFromStates(transaction);
+        }
+    }
+
+    /**
+     * Decides the transaction prepared before the restart by the rules of the termination protocol. A cohort member
+     * which committed or aborted determines the outcome. Otherwise the transaction is only committed if every cohort
+     * member reported P, as one which did not respond or is still in W may abort it on its own.
+     */
+    void decideFromStates(Transaction& transaction) {
+        transaction.gatheringStates = false;
+        const unsigned states = transaction.reportedStates;
+        const bool allPrepared = states == stateBit(P) and transaction.responders.size() == getMembers(transaction).size();
+        const bool commit = (states & stateBit(C)) or (not (states & stateBit(A)) and allPrepared);
+        const MessageType messageType = commit ? MessageType::DO_COMMIT : MessageType::DO_ABORT;
+        const RankSet& members = getMembers(transaction);
+        this->sendDurably(members, [this, &members, id = transaction.id, messageType] {
+            return this->communicator->send(id, messageType, "", members);
+        });
+        this->logWithState(transaction, util::concat("Sent ", messageType, " to the cohort after ", transaction.responders.size(),
+                                                     " of ", members.size(), " cohort member(s) reported their states"), messageType);
+        decide(transaction, commit ? C : A);
+    }
+
+    /**
+     * @return Every cohort member the transaction touches
+     */
+    const RankSet& getMembers(const Transaction& transaction) const {
+        return transaction.participants != nullptr ? *transaction.participants : cohort;
+    }
+
+    void handlePacket(const Packet& packet) {
+        Transaction* transaction = this->transactions.find(packet.transactionId);
+        if (transaction == nullptr) {
+            if (packet.transactionId < nextTransactionId and packet.messageType != MessageType::CRASH) {
+                // Responses still on their way when a transaction was decided without them
+                Logger::log(util::concat("Ignored a late response to the decided transaction ", packet.transactionId,
+                                         ": ", this->printPacket(packet)));
+                return;
+            }
+            this->logUnexpectedPacket(packet);
+            return;
+        }
+        this->recordMessageWait(*transaction, packet.messageType);
+        if (transaction->gatheringStates) {
+            recordState(*transaction, packet);
+            return;
+        }
+        switch (transaction->state) {
+            case W: {
+                recordResponse(*transaction, packet, MessageType::COMMIT_AGREE, "Y");
+                if (abortEarly(*transaction, "Sent DO_ABORT to the cohort because a cohort member did not agree to commit")) {
                     break;
                 }
-                case P: {
-                    this->logWithState("Entered state P");
-                    auto potentialPackets = receiveFromAll(ROUND_TIME);
-                    this->logWithState("Finished gathering responses for PREPARE_COMMIT from the cohort");
-                    if (potentialPackets.has_value()) {
-                        if (checkPackets(potentialPackets.value(), MessageType::COMMIT_ACK, "")) {
-                            this->logWithState("Got COMMIT_ACK from every cohort member");
-                            this->communicator->sendOthers(MessageType::DO_COMMIT, "");
-                            this->logWithState("Sent DO_COMMIT to the cohort");
-                            this->state = C;
-                            break;
-                        }
-                        this->logWithState("Some cohort members sent an unexpected message");
-                    } else {
-                        this->logWithState("There was a timeout - some cohort member did not acknowledge");
-                    }
-                    this->communicator->sendOthers(MessageType::DO_ABORT, "");
-                    this->logWithState("Sent DO_ABORT to the cohort because of a missing acknowledgement");
-                    this->state = A;
+                if (not receivedFromAll(*transaction)) {
                     break;
                 }
-                case A: {
-                    this->logWithState("Entered state A - aborted the transaction!");
-                    this->terminate = true;
-                    return;
+                this->metrics.gatherDuration(transaction->state).record(this->communicator->now() - transaction->phaseStartTime);
+                this->logWithState(*transaction, "Finished gathering responses for CAN_COMMIT from the cohort");
+                if (transaction->responsesAsExpected) {
+                    this->logWithState(*transaction, "Got positive response from every cohort member for CAN_COMMIT request", MessageType::COMMIT_AGREE);
+                    sendToCohort(*transaction, MessageType::PREPARE_COMMIT, describeBatch(*transaction));
+                    this->logWithState(*transaction, "Sent PREPARE_COMMIT to the cohort", MessageType::PREPARE_COMMIT);
+                    this->enterState(*transaction, P);
+                    break;
+                }
+                this->logWithState(*transaction, "Some cohort members did not agree to commit");
+                abort(*transaction, "Sent DO_ABORT to the cohort because did not get agreement from every cohort member");
+                break;
+            }
+            case P: {
+                recordResponse(*transaction, packet, MessageType::COMMIT_ACK, "");
+                if (abortEarly(*transaction, "Sent DO_ABORT to the cohort because a cohort member did not acknowledge")) {
+                    break;
+                }
+                if (not receivedFromAll(*transaction)) {
+                    break;
                 }
-                case C: {
-                    this->logWithState("Entered state C - committed the transaction!");
-                    this->terminate = true;
+                this->metrics.gatherDuration(transaction->state).record(this->communicator->now() - transaction->phaseStartTime);
+                this->logWithState(*transaction, "Finished gathering responses for PREPARE_COMMIT from the cohort");
+                if (transaction->responsesAsExpected) {
+                    this->logWithState(*transaction, "Got COMMIT_ACK from every cohort member", MessageType::COMMIT_ACK);
+                    sendToCohort(*transaction, MessageType::DO_COMMIT);
+                    this->logWithState(*transaction, "Sent DO_COMMIT to the cohort", MessageType::DO_COMMIT);
+                    decide(*transaction, C);
+                    break;
+                }
+                this->logWithState(*transaction, "Some cohort members sent an unexpected message");
+                abort(*transaction, "Sent DO_ABORT to the cohort because of a missing acknowledgement");
+                break;
+            }
+            default: {
+                this->logUnexpectedPacket(*transaction, packet);
+            }
+        }
+    }
+
+    void handleTimeout(Transaction& transaction) {
+        this->metrics.timeouts.fetch_add(1, std::memory_order_relaxed);
+        this->retireCollectiveChannel(transaction);
+        switch (transaction.state) {
+            case W: {
+                this->logWithState(transaction, "There was a timeout - some cohort members did not sent their vote");
+                abort(transaction, "Sent DO_ABORT to the cohort because did not get agreement from every cohort member");
+                break;
+            }
+            case P: {
+                if (transaction.gatheringStates) {
+                    this->logWithState(transaction, "There was a timeout - some cohort members did not report their states");
+                    decideFromStates(transaction);
+                    break;
+                }
+                this->logWithState(transaction, "There was a timeout - some cohort member did not acknowledge");
+                abort(transaction, "Sent DO_ABORT to the cohort because of a missing acknowledgement");
+                break;
+            }
+            default: {
+                break;
+            }
+        }
+    }
+
+    /**
+     * Aborts every transaction still waiting for the response of a cohort member the failure detector suspects,
+     * instead of waiting for its deadline.
+     * @return Whether any transaction was aborted
+     */
+    bool abortSuspected() {
+        const auto suspects = this->getSuspects();
+        if (suspects.empty()) {
+            return false;
+        }
+        std::vector<std::pair<TransactionId, ProcessId>> blocked;
+        this->transactions.forEach([&](const Transaction& transaction) {
+            // A transaction prepared before a restart is decided from the states reported until its deadline instead
+            if ((transaction.state != W and transaction.state != P) or transaction.gatheringStates) {
+                return;
+            }
+            for (ProcessId suspect : suspects) {
+                if (not transaction.responders.contains(suspect)
+                    and (transaction.participants == nullptr or transaction.participants->contains(suspect))) {
+                    blocked.emplace_back(transaction.id, suspect);
                     return;
                 }
             }
-            sleep();
-            this->crashIfSignalled();
+        });
+        for (const auto& [id, suspect] : blocked) {
+            Transaction* transaction = this->transactions.find(id);
+            if (transaction == nullptr or this->terminate) {
+                continue;
+            }
+            this->metrics.suspicions.fetch_add(1, std::memory_order_relaxed);
+            this->retireCollectiveChannel(*transaction);
+            this->logWithState(*transaction, util::concat("The cohort member ", suspect, " is suspected to have crashed - aborting without waiting for its response"));
+            abort(*transaction, "Sent DO_ABORT to the cohort because a cohort member is suspected to have crashed");
         }
+        return not blocked.empty();
     }
 
-    void sleep() override {
-        std::this_thread::sleep_for(std::chrono::milliseconds(this->random.randomBetween(MIN_SLEEP_TIME_COORDINATOR, MAX_SLEEP_TIME_COORDINATOR)));
+    /**
+     * Aborts the transaction as soon as a single unexpected response determines the outcome of the phase, instead of
+     * waiting for the rest of the cohort. Collective responses all arrive at once anyway, so those are still evaluated
+     * together.
+     * @return Whether the transaction was aborted
+     */
+    bool abortEarly(Transaction& transaction, const std::string& reason) {
+        if (transaction.responsesAsExpected or transaction.collective) {
+            return false;
+        }
+        this->logWithState(transaction, util::concat("Got an unexpected response after ", transaction.responders.size(),
+                                                     " of ", getExpectedResponses(transaction), " expected response(s) - aborting without waiting for the rest"));
+        abort(transaction, reason);
+        return true;
     }
 
-private:
+    void abort(Transaction& transaction, const std::string& reason) {
+        sendToCohort(transaction, MessageType::DO_ABORT);
+        this->logWithState(transaction, reason, MessageType::DO_ABORT);
+        decide(transaction, A);
+    }
 
     /**
-     * Receives all messages until it gets one from every process or a timeout occurs.
-     * @param timeoutMillis Threshold which aborts the receiving process when reached
-     * @return Set of received messages if every process participated or nullopt otherwise
+     * Sends a request to every cohort member the transaction touches, either point-to-point down the tree or collectively.
+     * A collective request expecting responses is immediately followed by the gathering of them.
      */
-    std::optional<std::unordered_set<Packet>> receiveFromAll(long timeoutMillis) {
-        using namespace std::chrono;
-        std::unordered_set<ProcessId> responders;
-        std::unordered_set<Packet> packets;
-        auto timeStarted = system_clock::now();
-        do {
-            auto taggedCommunicator = this->getTaggedCommunicator();
-            auto remainingTimeout = timeoutMillis - duration_cast<milliseconds>(system_clock::now() - timeStarted).count();
-            auto optionalPacket = taggedCommunicator->receive(remainingTimeout, this->defaultTag);
-            if (optionalPacket.has_value()) {
-                auto packet = optionalPacket.value();
-                packets.insert(packet);
-                responders.insert(packet.source);
-                if (responders.size() == (unsigned) taggedCommunicator->getNumberOfProcesses() - 1) {
-                    return packets;
-                }
-            } else {
-                // Round time elapsed
-                return std::nullopt;
+    void sendToCohort(Transaction& transaction, MessageType messageType, const std::string& message = "") {
+        if (transaction.participants != nullptr) {
+            // The sets of participants live as long as the process, so a deferred send can still refer to them
+            const auto& participants = *transaction.participants;
+            this->sendDurably(participants, [this, &participants, id = transaction.id, messageType, message] {
+                return this->communicator->send(id, messageType, message, participants);
+            });
+            return;
+        }
+        if (not transaction.collective) {
+            this->sendToPeers(transaction.id, messageType, message);
+            return;
+        }
+        this->sendRecorded(children, [&] { return this->collectiveVoting->broadcast(transaction.id, messageType); });
+        if (messageType == MessageType::CAN_COMMIT or messageType == MessageType::PREPARE_COMMIT) {
+            this->collectiveVoting->gather(transaction.id);
+        }
+    }
+
+    /**
+     * Records the response of a cohort member in the current phase of the transaction. Only the first response of
+     * every cohort member counts.
+     */
+    void recordResponse(Transaction& transaction, const Packet& packet, MessageType expectedType, const std::string& expectedMessage) {
+        if ((transaction.participants != nullptr and not transaction.participants->contains(packet.source))
+            or not transaction.responders.insert(packet.source)) {
+            this->logUnexpectedPacket(transaction, packet);
+            return;
+        }
+        if (packet.messageType != expectedType) {
+            transaction.responsesAsExpected = false;
+            return;
+        }
+        if (expectedType == MessageType::COMMIT_AGREE and transaction.batchSize > 1) {
+            // Only the transactions of the batch every cohort member agreed to are left to commit
+            transaction.batchMask &= parseBatchMask(packet.message).value_or(0);
+            if (transaction.batchMask == 0) {
+                transaction.responsesAsExpected = false;
+                return;
             }
-        } while (true);
+        } else if (packet.message != expectedMessage) {
+            transaction.responsesAsExpected = false;
+            return;
+        }
+        // The request was sent right before the transaction entered the current state
+        this->roundTripTimes.record(static_cast<std::size_t>(packet.source), this->communicator->now() - transaction.phaseStartTime);
+    }
+
+    bool receivedFromAll(const Transaction& transaction) {
+        return transaction.responders.size() == getExpectedResponses(transaction);
     }
 
-    template <typename Container>
-    bool checkPackets(Container packets, MessageType expectedType, const std::string& expectedMessage) {
-        return std::all_of(packets.begin(), packets.end(), [&](const Packet& p) { return p.messageType == expectedType and
-                                                                                  p.message == expectedMessage; });
+    std::size_t getExpectedResponses(const Transaction& transaction) const {
+        return transaction.participants != nullptr ? transaction.participants->size() : children.size();
     }
 
     void processCrashInput() {
+        Logger::registerThread("Input", this->communicator);
         while (true) {
-            Logger::registerThread("Input");
             ProcessId processToKill;
-            std::cin >> processToKill;
+            if (not (std::cin >> processToKill)) {
+                if (std::cin.eof()) {
+                    return;
+                }
+                std::cin.clear();
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                Logger::log("Unexpected input - ignoring");
+                continue;
+            }
             if (processToKill == this->communicator->getProcessId()) {
                 this->crashSignalReceived = true;
                 Logger::log("Killing the coordinator");
             } else if (processToKill >= 0 and processToKill < this->communicator->getNumberOfProcesses()) {
-                this->getTaggedCommunicator()->send(MessageType::CRASH, "", processToKill, this->crashTag);
+                this->sendRecorded(std::array<ProcessId, 1> {processToKill}, [&] {
+                    return this->getTaggedCommunicator()->send(0, MessageType::CRASH, "", processToKill, this->crashTag);
+                });
                 Logger::log(util::concat("Killing the process ", processToKill));
             } else {
                 Logger::log(util::concat("Unexpected input '", processToKill, "'", " - ignoring"));
             }
         }
     }
+
+    TransactionId nextTransactionId = 0;
+    /** When the transactions waiting for their batch to start arrived */
+    std::deque<std::chrono::steady_clock::time_point> arrivals;
+    unsigned arrivedTransactions = 0;
+    /** Transactions which arrived and are not decided yet, whether their batch started or not */
+    std::size_t transactionsInFlight = 0;
+    /** With in-order delivery, the first transaction whose decision is not delivered yet */
+    TransactionId nextDelivery = 0;
+    /** With in-order delivery, decided instances waiting for the ones before them, with the transactions they commit */
+    std::map<TransactionId, std::pair<Transaction, uint64_t>> undelivered;
+    /** The cohort members the coordinator exchanges messages with: the whole cohort in the star, the roots of the subtrees in a tree */
+    std::vector<ProcessId> children;
+    /** Every cohort member, which a restarted coordinator asks for the states of the transactions it had prepared */
+    RankSet cohort;
 };
 
 
@@ -0,0 +1,184 @@
+#ifndef INC_3PC_FAILUREDETECTOR_H
+#define INC_3PC_FAILUREDETECTOR_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <communication/ITaggedCommunicator.h>
+#include <logging/Logger.h>
+#include <util/StringConcat.h>
+
+/**
+ * Heartbeat failure detector with suspicion. A peer is suspected to have crashed once nothing was heard from it for
+ * the suspicion timeout, and the suspicion is withdrawn as soon as it is heard from again.
+ *
+ * Every packet the process receives from a peer counts as a heartbeat, and a heartbeat only goes to the peers the
+ * process has not sent anything to during the last interval, so a busy protocol needs no heartbeats at all, while
+ * the peers left out of the transactions of a participant subset still hear from the process.
+ * All the heartbeats of an interval go out as a single multicast on a tag of their own and are received by a thread
+ * of the detector, which wakes the main thread up with a HEARTBEAT packet on its tag whenever a peer becomes suspected.
+ */
+template <typename Tag>
+class FailureDetector {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * Starts watching the given peers, which are given the suspicion timeout to show up first.
+     * @param wakeUpTag Tag the main thread of the process receives on
+     */
+    FailureDetector(std::shared_ptr<ITaggedCommunicator<Tag>> communicator, std::vector<ProcessId> peers, Tag heartbeatTag,
+                    Tag wakeUpTag, Clock::duration interval, Clock::duration suspicionTimeout)
+        : communicator(std::move(communicator)), peers(std::move(peers)), heartbeatTag(heartbeatTag), wakeUpTag(wakeUpTag),
+          interval(interval), suspicionTimeout(suspicionTimeout),
+          lastHeard(static_cast<std::size_t>(this->communicator->getNumberOfProcesses())),
+          lastSent(static_cast<std::size_t>(this->communicator->getNumberOfProcesses())),
+          suspected(static_cast<std::size_t>(this->communicator->getNumberOfProcesses())) {
+        const auto now = this->communicator->now().time_since_epoch().count();
+        for (std::size_t peer = 0; peer < lastHeard.size(); ++peer) {
+            lastHeard[peer].store(now, std::memory_order_relaxed);
+            lastSent[peer].store(now, std::memory_order_relaxed);
+            suspected[peer].store(false, std::memory_order_relaxed);
+        }
+        heartbeatSender = std::thread([this] { run(); });
+    }
+
+    FailureDetector(const FailureDetector&) = delete;
+    FailureDetector& operator=(const FailureDetector&) = delete;
+
+    ~FailureDetector() {
+        stop();
+        heartbeatSender.join();
+    }
+
+    /**
+     * Stops sending heartbeats, so that the peers start suspecting this process. Suspicions are no longer updated.
+     */
+    void stop() {
+        if (stopped.exchange(true)) {
+            return;
+        }
+        communicator->send(0, MessageType::HEARTBEAT, "", communicator->getProcessId(), heartbeatTag);
+    }
+
+    /**
+     * Notes that a packet arrived from the given process.
+     */
+    void heard(ProcessId peer) {
+        if (peer >= 0 and static_cast<std::size_t>(peer) < lastHeard.size()) {
+            lastHeard[static_cast<std::size_t>(peer)].store(communicator->now().time_since_epoch().count(), std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Notes that the process sent a packet to the given processes, which makes their next heartbeat unnecessary.
+     */
+    template <typename Recipients>
+    void sent(const Recipients& recipients) {
+        const auto now = communicator->now().time_since_epoch().count();
+        for (ProcessId recipient : recipients) {
+            if (recipient >= 0 and static_cast<std::size_t>(recipient) < lastSent.size()) {
+                lastSent[static_cast<std::size_t>(recipient)].store(now, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool isSuspected(ProcessId peer) const {
+        return suspected[static_cast<std::size_t>(peer)].load(std::memory_order_relaxed);
+    }
+
+    bool hasSuspects() const {
+        return suspectCount.load(std::memory_order_relaxed) > 0;
+    }
+
+    /**
+     * @return The currently suspected peers
+     */
+    std::vector<ProcessId> getSuspects() const {
+        std::vector<ProcessId> suspects;
+        if (hasSuspects()) {
+            for (ProcessId peer : peers) {
+                if (isSuspected(peer)) {
+                    suspects.push_back(peer);
+                }
+            }
+        }
+        return suspects;
+    }
+
+private:
+
+    void run() {
+        using namespace std::chrono;
+        Logger::registerThread("Beat ", communicator);
+        auto nextHeartbeat = communicator->now() + interval;
+        // Receives at least once, like the crash signal receiver, as stop() wakes the detector up anyway
+        do {
+            const long timeoutMillis = std::max(0L, static_cast<long>(ceil<milliseconds>(nextHeartbeat - communicator->now()).count()));
+            auto packet = communicator->receive(timeoutMillis, heartbeatTag);
+            if (stopped) {
+                break;
+            }
+            if (packet.has_value()) {
+                heard(packet->source);
+            }
+            const auto now = communicator->now();
+            if (now < nextHeartbeat) {
+                continue;
+            }
+            recipients.clear();
+            for (ProcessId peer : peers) {
+                if (now - Clock::time_point(Clock::duration(lastSent[static_cast<std::size_t>(peer)].load(std::memory_order_relaxed))) >= interval) {
+                    recipients.insert(peer);
+                }
+            }
+            if (not recipients.empty()) {
+                communicator->send(0, MessageType::HEARTBEAT, "", recipients, heartbeatTag);
+            }
+            nextHeartbeat = now + interval;
+            updateSuspicions(now);
+        } while (not stopped);
+    }
+
+    void updateSuspicions(Clock::time_point now) {
+        bool newSuspects = false;
+        for (ProcessId peer : peers) {
+            const auto silence = now - Clock::time_point(Clock::duration(lastHeard[static_cast<std::size_t>(peer)].load(std::memory_order_relaxed)));
+            auto& peerSuspected = suspected[static_cast<std::size_t>(peer)];
+            if (silence > suspicionTimeout and not peerSuspected.load(std::memory_order_relaxed)) {
+                peerSuspected.store(true, std::memory_order_relaxed);
+                suspectCount.fetch_add(1, std::memory_order_relaxed);
+                newSuspects = true;
+                Logger::log(util::concat("Suspecting the process ", peer, " to have crashed - heard nothing from it for ",
+                                         std::chrono::duration_cast<std::chrono::milliseconds>(silence).count(), " ms"));
+            } else if (silence <= suspicionTimeout and peerSuspected.load(std::memory_order_relaxed)) {
+                peerSuspected.store(false, std::memory_order_relaxed);
+                suspectCount.fetch_sub(1, std::memory_order_relaxed);
+                Logger::log(util::concat("No longer suspecting the process ", peer));
+            }
+        }
+        if (newSuspects) {
+            communicator->send(0, MessageType::HEARTBEAT, "", communicator->getProcessId(), wakeUpTag);
+        }
+    }
+
+    std::shared_ptr<ITaggedCommunicator<Tag>> communicator;
+    std::vector<ProcessId> peers;
+    /** Peers due a heartbeat, reused for every interval */
+    RankSet recipients;
+    Tag heartbeatTag;
+    Tag wakeUpTag;
+    Clock::duration interval;
+    Clock::duration suspicionTimeout;
+    /** Indexed by process id, times as counts of Clock::duration since the epoch of the clock */
+    std::vector<std::atomic<Clock::rep>> lastHeard;
+    std::vector<std::atomic<Clock::rep>> lastSent;
+    std::vector<std::atomic<bool>> suspected;
+    std::atomic<unsigned> suspectCount {0};
+    std::atomic<bool> stopped {false};
+    std::thread heartbeatSender;
+};
+
+#endif //INC_3PC_FAILUREDETECTOR_H
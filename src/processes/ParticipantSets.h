@@ -0,0 +1,87 @@
+#ifndef INC_3PC_PARTICIPANTSETS_H
+#define INC_3PC_PARTICIPANTSETS_H
+
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <communication/ICommunicator.h>
+
+/**
+ * Cohort members the transactions touch when each of them only involves some shards. The transaction t touches the
+ * k consecutive cohort members from the rank 1 + (t * k) mod M on, wrapping around the M cohort members, so that
+ * consecutive transactions spread evenly over the cohort. A batch touches the union of the sets of its transactions.
+ *
+ * The sets leave out the process they are computed for and are kept for its lifetime, so references to them stay
+ * valid, e.g. for deferred sends.
+ */
+class ParticipantSets {
+public:
+
+    /**
+     * @param perTransaction Cohort members every transaction touches, 0 for the whole cohort
+     */
+    ParticipantSets(ProcessId self, ProcessId numberOfProcesses, unsigned perTransaction)
+        : self(self), cohortSize(static_cast<uint64_t>(numberOfProcesses) - 1), perTransaction(perTransaction) { }
+
+    /**
+     * @return Whether transactions touch only part of the cohort
+     */
+    bool isPartial() const {
+        return perTransaction > 0 and perTransaction < cohortSize;
+    }
+
+    /**
+     * @return The cohort members, other than this process, of the batch starting at the given transaction, or nullptr
+     * if the batch touches the whole cohort
+     */
+    const RankSet* get(TransactionId id, unsigned batchSize) {
+        const uint64_t length = static_cast<uint64_t>(batchSize) * perTransaction;
+        if (not isPartial() or length >= cohortSize) {
+            return nullptr;
+        }
+        const uint64_t start = static_cast<uint64_t>(id) * perTransaction % cohortSize;
+        auto [it, inserted] = sets.try_emplace({start, length});
+        if (inserted) {
+            for (uint64_t i = 0; i < length; ++i) {
+                const auto rank = static_cast<ProcessId>(1 + (start + i) % cohortSize);
+                if (rank != self) {
+                    it->second.insert(rank);
+                }
+            }
+        }
+        return &it->second;
+    }
+
+    /**
+     * @return Whether the single transaction touches the given cohort member
+     */
+    bool contains(TransactionId id, ProcessId rank) const {
+        if (not isPartial()) {
+            return rank != COORDINATOR_ID;
+        }
+        const uint64_t start = static_cast<uint64_t>(id) * perTransaction % cohortSize;
+        const uint64_t offset = (static_cast<uint64_t>(rank) - 1 + cohortSize - start) % cohortSize;
+        return rank != COORDINATOR_ID and offset < perTransaction;
+    }
+
+    /**
+     * @return The first transaction from the given one on which touches the given cohort member, or the given end if
+     * there is none before it
+     */
+    TransactionId nextInvolving(TransactionId from, TransactionId end, ProcessId rank) const {
+        TransactionId id = from;
+        while (id < end and not contains(id, rank)) {
+            ++id;
+        }
+        return id;
+    }
+
+private:
+    ProcessId self;
+    uint64_t cohortSize;
+    uint64_t perTransaction;
+    /** Indexed by the offset of the first cohort member and the number of them */
+    std::map<std::pair<uint64_t, uint64_t>, RankSet> sets;
+};
+
+#endif //INC_3PC_PARTICIPANTSETS_H
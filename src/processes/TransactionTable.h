@@ -0,0 +1,221 @@
+#ifndef INC_3PC_TRANSACTIONTABLE_H
+#define INC_3PC_TRANSACTIONTABLE_H
+
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <communication/ICommunicator.h>
+
+/**
+ * State of a single 3PC instance as seen by one process.
+ */
+struct Transaction {
+    TransactionId id;
+    State state = Q;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    /** When the process started working on the transaction */
+    std::chrono::steady_clock::time_point startTime;
+    /** When the transaction entered its current state */
+    std::chrono::steady_clock::time_point phaseStartTime;
+    /** Cohort members which responded in the current phase (used by the coordinator) */
+    RankSet responders;
+    /** Whether every response gathered in the current phase was the expected one (used by the coordinator) */
+    bool responsesAsExpected = true;
+    /** Whether the messages of the transaction go through a collective voting channel */
+    bool collective = false;
+    /** Number of transactions decided by this 3PC instance, numbered consecutively from its id */
+    unsigned batchSize = 1;
+    /** Transactions of the batch which are still to be committed, a bit per transaction */
+    uint64_t batchMask = 1;
+    /** When every transaction of the batch arrived, empty if the batch has a single one (used by the coordinator) */
+    std::vector<std::chrono::steady_clock::time_point> arrivalTimes;
+    /** Cohort member which replaces the coordinator in the termination protocol, -1 as long as the coordinator is trusted */
+    ProcessId backup = -1;
+    /** When the process gave up on the coordinator */
+    std::chrono::steady_clock::time_point terminationStartTime;
+    /** States the cohort members reported to this process as their backup or to the restarted coordinator, a bit per state */
+    unsigned reportedStates = 0;
+    /** Whether this process as the backup moved the cohort to P and awaits their COMMIT_ACK */
+    bool backupPrepared = false;
+    /** Whether the restarted coordinator gathers the states of the cohort to decide the transaction (used by the coordinator) */
+    bool gatheringStates = false;
+    /** Whether this process as a relay of the tree awaits the responses of its children to respond for its subtree */
+    bool subtreePending = false;
+    /** Cohort members the instance touches, nullptr for the whole cohort (used by the coordinator) */
+    const RankSet* participants = nullptr;
+};
+
+/**
+ * @return The mask of a batch of the given size in which every transaction is still to be committed
+ */
+inline uint64_t fullBatchMask(unsigned batchSize) {
+    return batchSize >= 64 ? ~uint64_t(0) : (uint64_t(1) << batchSize) - 1;
+}
+
+/**
+ * Batch masks travel in the messages as hexadecimal numbers.
+ */
+inline std::string formatBatchMask(uint64_t mask) {
+    char text[17];
+    auto result = std::to_chars(text, text + sizeof(text), mask, 16);
+    return std::string(text, result.ptr);
+}
+
+inline std::optional<uint64_t> parseBatchMask(std::string_view text) {
+    uint64_t mask = 0;
+    auto result = std::from_chars(text.data(), text.data() + text.size(), mask, 16);
+    if (result.ec != std::errc() or result.ptr != text.data() + text.size()) {
+        return std::nullopt;
+    }
+    return mask;
+}
+
+/**
+ * @return How the messages of the transaction describe its batch, e.g. "16 fff7" for the 16 transactions of which
+ * the fourth is no longer to be committed, or an empty string for a single transaction
+ */
+inline std::string describeBatch(const Transaction& transaction) {
+    if (transaction.batchSize == 1) {
+        return "";
+    }
+    return std::to_string(transaction.batchSize) + " " + formatBatchMask(transaction.batchMask);
+}
+
+/**
+ * Takes over the size of the batch the given description is of, and removes the transactions the description no
+ * longer has from the mask of the transaction. Descriptions which are empty or malformed leave it as it is.
+ */
+inline void applyBatchDescription(Transaction& transaction, std::string_view description) {
+    const auto separator = description.find(' ');
+    if (separator == std::string_view::npos) {
+        return;
+    }
+    unsigned batchSize = 0;
+    auto result = std::from_chars(description.data(), description.data() + separator, batchSize);
+    auto mask = parseBatchMask(description.substr(separator + 1));
+    if (result.ec != std::errc() or batchSize == 0 or batchSize > MAX_BATCH_SIZE or not mask.has_value()) {
+        return;
+    }
+    if (transaction.batchSize != batchSize) {
+        transaction.batchSize = batchSize;
+        transaction.batchMask = fullBatchMask(batchSize);
+    }
+    transaction.batchMask &= mask.value();
+}
+
+/**
+ * @return The bit of the state in a set of states, e.g. Transaction::reportedStates
+ */
+inline unsigned stateBit(State state) {
+    return 1u << static_cast<unsigned>(state);
+}
+
+/**
+ * @return The state a STATE_REPORT starts with, e.g. P for "P 16 fff7"
+ */
+inline std::optional<State> parseReportedState(std::string_view report) {
+    const auto text = report.substr(0, report.find(' '));
+    for (const auto& [state, name] : stateString) {
+        if (name == text) {
+            return state;
+        }
+    }
+    return std::nullopt;
+}
+
+/**
+ * Set of in-flight transactions indexed by their id, which also keeps track of the earliest phase deadline.
+ */
+class TransactionTable {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Transaction& insert(TransactionId id) {
+        auto& transaction = transactions[id];
+        transaction.id = id;
+        return transaction;
+    }
+
+    Transaction* find(TransactionId id) {
+        auto it = transactions.find(id);
+        return it == transactions.end() ? nullptr : &it->second;
+    }
+
+    void erase(TransactionId id) {
+        transactions.erase(id);
+    }
+
+    void setDeadline(Transaction& transaction, Clock::time_point deadline) {
+        transaction.deadline = deadline;
+        deadlines.push({deadline, transaction.id});
+    }
+
+    /**
+     * @return The earliest deadline among the transactions or nullopt if none of them awaits anything
+     */
+    std::optional<Clock::time_point> nextDeadline() {
+        discardStaleDeadlines();
+        if (deadlines.empty()) {
+            return std::nullopt;
+        }
+        return deadlines.top().first;
+    }
+
+    /**
+     * Calls the given function for every transaction whose deadline has passed. The deadline is consumed,
+     * so the function has to set a new one if the transaction is still supposed to wait for something.
+     */
+    void forEachExpired(Clock::time_point now, const std::function<void(Transaction&)>& function) {
+        discardStaleDeadlines();
+        while (not deadlines.empty() and deadlines.top().first <= now) {
+            TransactionId id = deadlines.top().second;
+            deadlines.pop();
+            Transaction& transaction = transactions.at(id);
+            transaction.deadline = Clock::time_point::max();
+            function(transaction);
+            discardStaleDeadlines();
+        }
+    }
+
+    void forEach(const std::function<void(const Transaction&)>& function) const {
+        for (const auto& [id, transaction] : transactions) {
+            function(transaction);
+        }
+    }
+
+    bool empty() const {
+        return transactions.empty();
+    }
+
+    std::size_t size() const {
+        return transactions.size();
+    }
+
+private:
+
+    /** Drops heap entries of finished transactions and entries superseded by a later setDeadline call */
+    void discardStaleDeadlines() {
+        while (not deadlines.empty()) {
+            auto [deadline, id] = deadlines.top();
+            auto it = transactions.find(id);
+            if (it != transactions.end() and it->second.deadline == deadline) {
+                return;
+            }
+            deadlines.pop();
+        }
+    }
+
+    using Deadline = std::pair<Clock::time_point, TransactionId>;
+
+    std::unordered_map<TransactionId, Transaction> transactions;
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<>> deadlines;
+};
+
+#endif //INC_3PC_TRANSACTIONTABLE_H
@@ -0,0 +1,54 @@
+#ifndef INC_3PC_TREETOPOLOGY_H
+#define INC_3PC_TREETOPOLOGY_H
+
+#include <algorithm>
+#include <vector>
+#include <communication/ICommunicator.h>
+
+/**
+ * Arrangement of the ranks the protocol messages travel along: a tree rooted at the coordinator in which the children of
+ * a rank r are r * fanOut + 1 to r * fanOut + fanOut. Requests go down the tree, and every inner cohort member relays
+ * them to its children and aggregates their responses before it responds itself. A fan-out of 0, or one at least the
+ * size of the cohort, is the star in which the coordinator exchanges messages with every cohort member directly.
+ */
+class TreeTopology {
+public:
+
+    TreeTopology(ProcessId rank, ProcessId numberOfProcesses, unsigned fanOut)
+        : rank(rank), numberOfProcesses(numberOfProcesses),
+          fanOut(fanOut == 0 ? std::max<ProcessId>(numberOfProcesses - 1, 1) : static_cast<ProcessId>(fanOut)) { }
+
+    /**
+     * @return The rank requests come from, -1 for the coordinator
+     */
+    ProcessId getParent() const {
+        return rank == COORDINATOR_ID ? -1 : (rank - 1) / fanOut;
+    }
+
+    std::vector<ProcessId> getChildren() const {
+        std::vector<ProcessId> children;
+        for (ProcessId child = rank * fanOut + 1; child <= rank * fanOut + fanOut and child < numberOfProcesses; ++child) {
+            children.push_back(child);
+        }
+        return children;
+    }
+
+    /**
+     * @return Number of levels below the rank, 0 for a leaf
+     */
+    unsigned getHeight() const {
+        unsigned height = 0;
+        // The leftmost path is the longest one
+        for (long descendant = rank; descendant * fanOut + 1 < numberOfProcesses; descendant = descendant * fanOut + 1) {
+            ++height;
+        }
+        return height;
+    }
+
+private:
+    ProcessId rank;
+    ProcessId numberOfProcesses;
+    ProcessId fanOut;
+};
+
+#endif //INC_3PC_TREETOPOLOGY_H
@@ -0,0 +1,54 @@
+#ifndef INC_3PC_WALFORMAT_H
+#define INC_3PC_WALFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <util/Crc32c.h>
+
+/**
+ * Layout of the per-rank write-ahead log files.
+ *
+ * A file starts with a WalFileHeader followed by a sequence of fixed-size WalRecords. Every record carries the CRC-32C
+ * of its other bytes, so a record torn by a crash in the middle of a write is recognized and ends the log. Records are
+ * numbered consecutively from 0. All integers are stored in the writer's byte order.
+ *
+ * A log truncated by a checkpoint starts with a CHECKPOINT record for every recently decided transaction and for every
+ * transaction in flight at that time, closed by a CHECKPOINT_END record, and continues with the STATE records written after the checkpoint.
+ */
+
+#define WAL_MAGIC "3PC-WAL\n"
+#define WAL_VERSION 1
+
+struct WalFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t rank;
+};
+
+enum class WalRecordKind : uint8_t {
+    /** The transaction entered the given state */
+    STATE,
+    /** The transaction was in the given state at the checkpoint */
+    CHECKPOINT,
+    /** End of the checkpoint, whose transaction id is the lowest one no record was written for before it */
+    CHECKPOINT_END
+};
+
+struct WalRecord {
+    uint32_t sequenceNumber;
+    uint32_t transactionId;
+    WalRecordKind kind;
+    uint8_t state;
+    uint16_t reserved;
+    /** CRC-32C of the preceding fields */
+    uint32_t checksum;
+};
+
+static_assert(sizeof(WalFileHeader) == 16, "Log file header must not contain padding");
+static_assert(sizeof(WalRecord) == 16, "Log record must not contain padding");
+
+inline uint32_t computeChecksum(const WalRecord& record) {
+    return crc32c(&record, offsetof(WalRecord, checksum));
+}
+
+#endif //INC_3PC_WALFORMAT_H
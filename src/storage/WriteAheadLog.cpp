@@ -0,0 +1,227 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <logging/Logger.h>
+#include <util/StringConcat.h>
+#include "WriteAheadLog.h"
+
+namespace {
+    std::runtime_error ioError(const std::string& action, const std::string& path) {
+        return std::runtime_error("Could not " + action + " the write-ahead log " + path + ": " + std::strerror(errno));
+    }
+
+    /** Makes the creation or renaming of a file durable, which fsyncing the file itself does not */
+    void syncDirectoryOf(const std::string& path) {
+        const auto separator = path.find_last_of('/');
+        const std::string directory = separator == std::string::npos ? "." : path.substr(0, std::max<std::size_t>(separator, 1));
+        int directoryDescriptor = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+        if (directoryDescriptor >= 0) {
+            ::fsync(directoryDescriptor);
+            ::close(directoryDescriptor);
+        }
+    }
+
+    bool isFinal(State state) {
+        return state == A or state == C;
+    }
+}
+
+WriteAheadLog::WriteAheadLog(const std::string& path, ProcessId rank, bool recover, std::size_t checkpointInterval)
+    : path(path), rank(rank), checkpointInterval(checkpointInterval) {
+    if (recover and ::access(path.c_str(), F_OK) == 0) {
+        this->recover();
+    } else {
+        create();
+    }
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    ::close(fileDescriptor);
+}
+
+void WriteAheadLog::create() {
+    fileDescriptor = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fileDescriptor < 0) {
+        throw ioError("create", path);
+    }
+    writeHeader(fileDescriptor);
+    if (::fdatasync(fileDescriptor) != 0) {
+        throw ioError("sync", path);
+    }
+    syncDirectoryOf(path);
+}
+
+void WriteAheadLog::recover() {
+    const auto begin = std::chrono::steady_clock::now();
+    fileDescriptor = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fileDescriptor < 0) {
+        throw ioError("open", path);
+    }
+    struct stat status {};
+    if (::fstat(fileDescriptor, &status) != 0) {
+        throw ioError("read", path);
+    }
+    const auto size = static_cast<std::size_t>(status.st_size);
+    if (size < sizeof(WalFileHeader)) {
+        throw std::runtime_error("The write-ahead log " + path + " has no header");
+    }
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    if (mapping == MAP_FAILED) {
+        throw ioError("map", path);
+    }
+    ::madvise(mapping, size, MADV_SEQUENTIAL);
+    const auto* bytes = static_cast<const char*>(mapping);
+
+    WalFileHeader header {};
+    std::memcpy(&header, bytes, sizeof(header));
+    if (std::memcmp(header.magic, WAL_MAGIC, sizeof(header.magic)) != 0 or header.version != WAL_VERSION
+        or header.rank != static_cast<uint32_t>(rank)) {
+        ::munmap(mapping, size);
+        throw std::runtime_error(util::concat("The write-ahead log ", path, " is not a version ", WAL_VERSION, " log of the rank ", rank));
+    }
+    std::size_t offset = sizeof(WalFileHeader);
+    while (offset + sizeof(WalRecord) <= size) {
+        WalRecord record {};
+        std::memcpy(&record, bytes + offset, sizeof(record));
+        // Records are written in order, so the first invalid one is where a crash interrupted the log
+        if (record.checksum != computeChecksum(record) or record.sequenceNumber != nextSequenceNumber) {
+            break;
+        }
+        apply(record);
+        ++nextSequenceNumber;
+        offset += sizeof(WalRecord);
+    }
+    ::munmap(mapping, size);
+
+    // Appending continues right after the last valid record
+    if (offset != size and ::ftruncate(fileDescriptor, static_cast<off_t>(offset)) != 0) {
+        throw ioError("truncate", path);
+    }
+    if (::lseek(fileDescriptor, static_cast<off_t>(offset), SEEK_SET) < 0) {
+        throw ioError("seek", path);
+    }
+    recovery.inFlight.insert(inFlight.begin(), inFlight.end());
+    recovery.decided = decided;
+    recovery.nextTransactionId = nextTransactionId;
+    recovery.records = nextSequenceNumber;
+    recovery.duration = std::chrono::steady_clock::now() - begin;
+}
+
+void WriteAheadLog::apply(const WalRecord& record) {
+    const auto transactionId = static_cast<TransactionId>(record.transactionId);
+    const auto state = static_cast<State>(record.state);
+    switch (record.kind) {
+        case WalRecordKind::STATE:
+        case WalRecordKind::CHECKPOINT: {
+            if (isFinal(state)) {
+                inFlight.erase(transactionId);
+                decided[transactionId] = state;
+                if (decided.size() > DECISION_HISTORY) {
+                    decided.erase(decided.begin());
+                }
+            } else {
+                inFlight[transactionId] = state;
+            }
+            nextTransactionId = std::max(nextTransactionId, transactionId + 1);
+            break;
+        }
+        case WalRecordKind::CHECKPOINT_END: {
+            nextTransactionId = std::max(nextTransactionId, transactionId);
+            break;
+        }
+    }
+    ++recordsSinceCheckpoint;
+}
+
+WalRecord WriteAheadLog::makeRecord(WalRecordKind kind, TransactionId transactionId, State state) {
+    WalRecord record {};
+    record.sequenceNumber = nextSequenceNumber++;
+    record.transactionId = static_cast<uint32_t>(transactionId);
+    record.kind = kind;
+    record.state = static_cast<uint8_t>(state);
+    record.checksum = computeChecksum(record);
+    return record;
+}
+
+void WriteAheadLog::append(TransactionId transactionId, State state) {
+    buffer.push_back(makeRecord(WalRecordKind::STATE, transactionId, state));
+    apply(buffer.back());
+}
+
+std::size_t WriteAheadLog::sync() {
+    const std::size_t records = buffer.size();
+    if (records == 0) {
+        return 0;
+    }
+    writeAll(fileDescriptor, buffer.data(), records * sizeof(WalRecord));
+    buffer.clear();
+    if (::fdatasync(fileDescriptor) != 0) {
+        throw ioError("sync", path);
+    }
+    if (checkpointInterval > 0 and recordsSinceCheckpoint >= checkpointInterval) {
+        checkpoint();
+    }
+    return records;
+}
+
+void WriteAheadLog::checkpoint() {
+    // The checkpoint is written to a file of its own, which atomically replaces the log once it is complete
+    const std::string checkpointPath = path + ".checkpoint";
+    int checkpointDescriptor = ::open(checkpointPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (checkpointDescriptor < 0) {
+        throw ioError("create a checkpoint of", path);
+    }
+    writeHeader(checkpointDescriptor);
+
+    // Transactions in order of their ids, so that recovery resumes them in the order they were started
+    std::map<TransactionId, State> snapshot(inFlight.begin(), inFlight.end());
+    std::vector<WalRecord> records;
+    records.reserve(decided.size() + snapshot.size() + 1);
+    nextSequenceNumber = 0;
+    for (const auto& [transactionId, state] : decided) {
+        records.push_back(makeRecord(WalRecordKind::CHECKPOINT, transactionId, state));
+    }
+    for (const auto& [transactionId, state] : snapshot) {
+        records.push_back(makeRecord(WalRecordKind::CHECKPOINT, transactionId, state));
+    }
+    records.push_back(makeRecord(WalRecordKind::CHECKPOINT_END, nextTransactionId, Q));
+    writeAll(checkpointDescriptor, records.data(), records.size() * sizeof(WalRecord));
+    if (::fdatasync(checkpointDescriptor) != 0 or ::rename(checkpointPath.c_str(), path.c_str()) != 0) {
+        ::close(checkpointDescriptor);
+        throw ioError("checkpoint", path);
+    }
+    syncDirectoryOf(path);
+    ::close(fileDescriptor);
+    fileDescriptor = checkpointDescriptor;
+    recordsSinceCheckpoint = 0;
+    ++checkpoints;
+    Logger::log(util::concat("Checkpointed ", snapshot.size(), " transaction(s) in flight and truncated the write-ahead log"));
+}
+
+void WriteAheadLog::writeHeader(int descriptor) {
+    WalFileHeader header {};
+    std::memcpy(header.magic, WAL_MAGIC, sizeof(header.magic));
+    header.version = WAL_VERSION;
+    header.rank = static_cast<uint32_t>(rank);
+    writeAll(descriptor, &header, sizeof(header));
+}
+
+void WriteAheadLog::writeAll(int descriptor, const void* data, std::size_t size) {
+    const auto* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        const ssize_t written = ::write(descriptor, bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw ioError("write", path);
+        }
+        bytes += written;
+        size -= static_cast<std::size_t>(written);
+    }
+}
@@ -0,0 +1,109 @@
+#ifndef INC_3PC_WRITEAHEADLOG_H
+#define INC_3PC_WRITEAHEADLOG_H
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <communication/ICommunicator.h>
+#include "WalFormat.h"
+
+/**
+ * Append-only log of the state transitions of one process, made durable with fdatasync. Appending only buffers
+ * the record in memory, so that all the records appended between two calls of sync() share a single flush
+ * (group commit). Whatever depends on a record, e.g. a vote sent to the coordinator, must wait for the next sync().
+ *
+ * The log keeps track of the transactions in flight, i.e. not yet committed or aborted, and of the recent decisions,
+ * which peers recovering along with the process may still ask for. Every checkpoint interval records, sync()
+ * replaces the log by a checkpoint of both, so recovering from the log takes time proportional to
+ * the work in flight and the records since the last checkpoint, no matter how long the process has been running.
+ *
+ * Not thread-safe, every process has to use it from its main thread only.
+ */
+class WriteAheadLog {
+public:
+
+    /**
+     * What a process finds in its log after a restart.
+     */
+    struct Recovery {
+        /** Last state of every transaction which was neither committed nor aborted */
+        std::map<TransactionId, State> inFlight;
+        /** Final state of the most recently decided transactions, up to DECISION_HISTORY of them */
+        std::map<TransactionId, State> decided;
+        /** Lowest transaction id the log has no record of, and neither of any higher one */
+        TransactionId nextTransactionId = 0;
+        /** Valid records read, a torn record at the end of the log is dropped */
+        std::size_t records = 0;
+        std::chrono::steady_clock::duration duration {};
+    };
+
+    /**
+     * Opens the log file, replacing an existing one unless the process recovers from it. Throws std::runtime_error if
+     * the file cannot be read or written.
+     * @param checkpointInterval Number of records after which the log is truncated by a checkpoint, 0 for never
+     */
+    WriteAheadLog(const std::string& path, ProcessId rank, bool recover, std::size_t checkpointInterval);
+
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    /**
+     * Buffers a record of the transaction entering the given state.
+     */
+    void append(TransactionId transactionId, State state);
+
+    /**
+     * @return Whether records were appended since the last sync()
+     */
+    bool hasUnsynced() const {
+        return not buffer.empty();
+    }
+
+    /**
+     * Writes the buffered records and waits until they are on disk, then takes a checkpoint if one is due. Throws
+     * std::runtime_error if that fails.
+     * @return Number of records written
+     */
+    std::size_t sync();
+
+    /**
+     * @return What the log contained when it was opened, empty unless the process recovers
+     */
+    const Recovery& getRecovery() const {
+        return recovery;
+    }
+
+    unsigned long getCheckpointCount() const {
+        return checkpoints;
+    }
+
+private:
+    void create();
+    void recover();
+    void apply(const WalRecord& record);
+    void checkpoint();
+    void writeHeader(int descriptor);
+    void writeAll(int descriptor, const void* data, std::size_t size);
+    WalRecord makeRecord(WalRecordKind kind, TransactionId transactionId, State state);
+
+    std::string path;
+    ProcessId rank;
+    int fileDescriptor = -1;
+    std::size_t checkpointInterval;
+    uint32_t nextSequenceNumber = 0;
+    std::vector<WalRecord> buffer;
+    /** State of the transactions in flight as of the records written so far */
+    std::unordered_map<TransactionId, State> inFlight;
+    /** Recent decisions as of the records written so far */
+    std::map<TransactionId, State> decided;
+    TransactionId nextTransactionId = 0;
+    std::size_t recordsSinceCheckpoint = 0;
+    unsigned long checkpoints = 0;
+    Recovery recovery;
+};
+
+#endif //INC_3PC_WRITEAHEADLOG_H
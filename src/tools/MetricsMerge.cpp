@@ -0,0 +1,63 @@
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <util/Metrics.h>
+
+/**
+ * Aggregates the metrics files written by the processes of one or more runs: counters are summed up and histograms
+ * merged bucket by bucket, so the percentiles cover the samples of every input.
+ *
+ * Usage: 3PC-metrics-merge [--raw] METRICS_FILE...
+ */
+
+void printUsage() {
+    std::cerr << "Usage: 3PC-metrics-merge [--raw] METRICS_FILE...\n"
+                 "  --raw  print the merged metrics in the file format, so that they can be merged again" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    bool raw = false;
+    std::vector<std::string> inputPaths;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view argument = argv[i];
+        if (argument == "--raw") {
+            raw = true;
+        } else if (argument.substr(0, 2) == "--") {
+            printUsage();
+            return 1;
+        } else {
+            inputPaths.emplace_back(argument);
+        }
+    }
+    if (inputPaths.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    try {
+        MetricsDump metricsDump;
+        for (const auto& path : inputPaths) {
+            std::ifstream input(path);
+            if (not input) {
+                throw std::runtime_error("Could not open " + path);
+            }
+            try {
+                metricsDump.read(input);
+            } catch (const std::runtime_error& e) {
+                throw std::runtime_error(path + ": " + e.what());
+            }
+        }
+        if (raw) {
+            metricsDump.write(std::cout);
+        } else {
+            metricsDump.print(std::cout);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Joins the timelines written by the processes of a run into a single Chrome trace, in which the messages between
+ * the ranks show up as arrows. Relies on the timeline files holding one event per line.
+ *
+ * Usage: 3PC-timeline-merge [--output=FILE] TIMELINE_FILE...
+ */
+
+void printUsage() {
+    std::cerr << "Usage: 3PC-timeline-merge [--output=FILE] TIMELINE_FILE..." << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::string outputPath;
+    std::vector<std::string> inputPaths;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view argument = argv[i];
+        if (argument.substr(0, 9) == "--output=") {
+            outputPath = std::string(argument.substr(9));
+        } else if (argument.substr(0, 2) == "--") {
+            printUsage();
+            return 1;
+        } else {
+            inputPaths.emplace_back(argument);
+        }
+    }
+    if (inputPaths.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    std::ofstream outputFile;
+    if (not outputPath.empty()) {
+        outputFile.open(outputPath);
+        if (not outputFile) {
+            std::cerr << "Could not open " << outputPath << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& output = outputPath.empty() ? std::cout : outputFile;
+
+    output << '[';
+    const char* separator = "\n";
+    for (const auto& path : inputPaths) {
+        std::ifstream input(path);
+        if (not input) {
+            std::cerr << "Could not open " << path << std::endl;
+            return 1;
+        }
+        std::string line;
+        while (std::getline(input, line)) {
+            if (line == "[" or line == "]") {
+                continue;
+            }
+            if (not line.empty() and line.back() == ',') {
+                line.pop_back();
+            }
+            output << separator << line;
+            separator = ",\n";
+        }
+    }
+    output << "\n]\n";
+    return 0;
+}
@@ -0,0 +1,413 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <util/Define.h>
+#include <logging/TraceFormat.h>
+
+/**
+ * Merges binary per-rank trace files into a single log ordered by (Lamport time, rank).
+ *
+ * Every input is memory-mapped and read sequentially, while already consumed pages are released back to the kernel,
+ * so the memory usage depends on the number of inputs rather than their size. Each input is read ahead by a bounded
+ * window, which puts entries its writer flushed slightly out of order back in place.
+ *
+ * Usage: 3PC-trace-merge [--format=text|json] [--output=FILE] TRACE_FILE...
+ */
+
+#define CONSUMED_BYTES_TO_RELEASE (64 << 20)
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+#define REORDER_WINDOW_ENTRIES (1 << 16)
+
+enum class OutputFormat {
+    TEXT, JSON
+};
+
+class TraceFile {
+public:
+
+    explicit TraceFile(const std::string& path) : path(path) {
+        int descriptor = open(path.c_str(), O_RDONLY);
+        if (descriptor < 0) {
+            throw std::runtime_error("Could not open " + path);
+        }
+        struct stat fileStatus {};
+        fstat(descriptor, &fileStatus);
+        size = static_cast<std::size_t>(fileStatus.st_size);
+        if (size < sizeof(TraceFileHeader)) {
+            close(descriptor);
+            throw std::runtime_error(path + " is not a trace file");
+        }
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        close(descriptor);
+        if (mapping == MAP_FAILED) {
+            throw std::runtime_error("Could not map " + path);
+        }
+        data = static_cast<const char*>(mapping);
+        madvise(mapping, size, MADV_SEQUENTIAL);
+
+        TraceFileHeader fileHeader {};
+        std::memcpy(&fileHeader, data, sizeof(fileHeader));
+        if (std::memcmp(fileHeader.magic, TRACE_MAGIC, sizeof(fileHeader.magic)) != 0 or fileHeader.version != TRACE_VERSION) {
+            throw std::runtime_error(path + " is not a trace file of a supported version");
+        }
+        position = sizeof(fileHeader);
+    }
+
+    TraceFile(const TraceFile&) = delete;
+    TraceFile& operator=(const TraceFile&) = delete;
+
+    ~TraceFile() {
+        munmap(const_cast<char*>(data), size);
+    }
+
+    /**
+     * Moves to the next log entry. Entries are read ahead into a window of REORDER_WINDOW_ENTRIES, from which the
+     * earliest one is taken, so entries a writer flushed out of order are put back in place unless they were displaced
+     * further than the window.
+     * @return False if there are no more entries
+     */
+    bool next() {
+        while (window.size() < REORDER_WINDOW_ENTRIES and readEntry()) { }
+        if (window.empty()) {
+            return false;
+        }
+        std::pop_heap(window.begin(), window.end(), later);
+        const bool outOfOrder = hasEntry and later(current, window.back());
+        current = std::move(window.back());
+        window.pop_back();
+        if (outOfOrder) {
+            ++outOfOrderEntries;
+        }
+        hasEntry = true;
+        return true;
+    }
+
+    const TraceRecordHeader& getHeader() const {
+        return current.header;
+    }
+
+    std::string_view getPayload() const {
+        return current.payload;
+    }
+
+    std::string_view getThreadName() const {
+        return current.threadName != nullptr ? std::string_view(*current.threadName) : std::string_view();
+    }
+
+    unsigned long getOutOfOrderEntries() const {
+        return outOfOrderEntries;
+    }
+
+    const std::string& getPath() const {
+        return path;
+    }
+
+private:
+
+    struct Entry {
+        TraceRecordHeader header {};
+        std::string payload;
+        /** Name of the thread at the time of the entry */
+        const std::string* threadName = nullptr;
+    };
+
+    /**
+     * Orders entries as the merge does, so that a file holding the entries of several ranks is read in the merged order
+     */
+    static bool later(const Entry& first, const Entry& second) {
+        const auto& a = first.header;
+        const auto& b = second.header;
+        return std::tie(a.lamportTime, a.rank, a.sequenceNumber) > std::tie(b.lamportTime, b.rank, b.sequenceNumber);
+    }
+
+    /**
+     * Adds the next log entry of the file to the window, taking note of the thread names encountered on the way. A
+     * record cut off by the end of the file, as left behind by a writer that crashed, ends the file.
+     * @return False if there are no more entries
+     */
+    bool readEntry() {
+        while (position + sizeof(TraceRecordHeader) <= size) {
+            TraceRecordHeader header {};
+            std::memcpy(&header, data + position, sizeof(header));
+            if (position + sizeof(header) + header.payloadLength > size) {
+                break;
+            }
+            position += sizeof(header);
+            std::string payload(data + position, header.payloadLength);
+            position += header.payloadLength;
+            releaseConsumedPages();
+            if (header.kind == TraceRecordKind::THREAD_NAME) {
+                if (threadNames.size() <= header.thread) {
+                    threadNames.resize(header.thread + 1u, nullptr);
+                }
+                threadNames[header.thread] = &knownThreadNames.emplace_back(std::move(payload));
+                continue;
+            }
+            const std::string* threadName = header.thread < threadNames.size() ? threadNames[header.thread] : nullptr;
+            window.push_back(Entry {header, std::move(payload), threadName});
+            std::push_heap(window.begin(), window.end(), later);
+            return true;
+        }
+        if (position < size) {
+            std::cerr << path << ": the last " << size - position
+                      << " bytes are an incomplete record and were ignored" << std::endl;
+            position = size;
+        }
+        return false;
+    }
+
+    /**
+     * Entries in the window are copies, so everything up to the read position can go.
+     */
+    void releaseConsumedPages() {
+        if (position - releasedBytes < CONSUMED_BYTES_TO_RELEASE) {
+            return;
+        }
+        const auto pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        const std::size_t releaseUpTo = position / pageSize * pageSize;
+        if (releaseUpTo > releasedBytes) {
+            madvise(const_cast<char*>(data) + releasedBytes, releaseUpTo - releasedBytes, MADV_DONTNEED);
+            releasedBytes = releaseUpTo;
+        }
+    }
+
+    std::string path;
+    const char* data = nullptr;
+    std::size_t size = 0;
+    std::size_t position = 0;
+    std::size_t releasedBytes = 0;
+    /** Entries read ahead, as a heap with the earliest one on top */
+    std::vector<Entry> window;
+    Entry current;
+    bool hasEntry = false;
+    unsigned long outOfOrderEntries = 0;
+    /** Current name of every thread, pointing into knownThreadNames */
+    std::vector<const std::string*> threadNames;
+    std::deque<std::string> knownThreadNames;
+};
+
+class OutputWriter {
+public:
+
+    OutputWriter(FILE* file, OutputFormat format) : file(file), format(format) {
+        buffer.reserve(OUTPUT_BUFFER_SIZE + 4 * LOG_RECORD_MESSAGE_SIZE);
+    }
+
+    ~OutputWriter() {
+        flush();
+    }
+
+    void write(const TraceFile& trace) {
+        if (format == OutputFormat::TEXT) {
+            writeText(trace);
+        } else {
+            writeJson(trace);
+        }
+        if (buffer.size() >= OUTPUT_BUFFER_SIZE) {
+            flush();
+        }
+    }
+
+    void flush() {
+        std::fwrite(buffer.data(), 1, buffer.size(), file);
+        buffer.clear();
+    }
+
+private:
+
+    void writeText(const TraceFile& trace) {
+        const TraceRecordHeader& header = trace.getHeader();
+        buffer += "[TS ";
+        appendPadded(header.lamportTime);
+        buffer += ':';
+        appendPadded(header.sequenceNumber);
+        buffer += ' ';
+        buffer += getFormattedTime(header.wallTime);
+        buffer += " Process ";
+        buffer += std::to_string(header.rank);
+        buffer += " Thread ";
+        buffer += trace.getThreadName();
+        buffer += "]: ";
+        if (header.flags & TRACE_HAS_STATE) {
+            buffer += '[';
+            buffer += stateString.at(static_cast<State>(header.state));
+            buffer += std::to_string(header.rank);
+            buffer += " T";
+            buffer += std::to_string(header.transactionId);
+            buffer += "] ";
+        }
+        buffer += trace.getPayload();
+        buffer += '\n';
+    }
+
+    void writeJson(const TraceFile& trace) {
+        const TraceRecordHeader& header = trace.getHeader();
+        buffer += "{\"lamportTime\":";
+        buffer += std::to_string(header.lamportTime);
+        buffer += ",\"rank\":";
+        buffer += std::to_string(header.rank);
+        buffer += ",\"sequence\":";
+        buffer += std::to_string(header.sequenceNumber);
+        buffer += ",\"time\":";
+        buffer += std::to_string(header.wallTime);
+        buffer += ",\"thread\":";
+        appendJsonString(trace.getThreadName());
+        if (header.flags & TRACE_HAS_STATE) {
+            buffer += ",\"state\":\"";
+            buffer += stateString.at(static_cast<State>(header.state));
+            buffer += "\",\"transaction\":";
+            buffer += std::to_string(header.transactionId);
+        }
+        if (header.flags & TRACE_HAS_MESSAGE_TYPE) {
+            buffer += ",\"messageType\":\"";
+            buffer += messageTypeString.at(static_cast<MessageType>(header.messageType));
+            buffer += '"';
+        }
+        buffer += ",\"message\":";
+        appendJsonString(trace.getPayload());
+        buffer += "}\n";
+    }
+
+    void appendPadded(unsigned long number) {
+        std::string numberAsString = std::to_string(number);
+        if (numberAsString.length() < LOGGER_NUMBER_DIGITS) {
+            buffer.append(LOGGER_NUMBER_DIGITS - numberAsString.length(), '0');
+        }
+        buffer += numberAsString;
+    }
+
+    void appendJsonString(std::string_view text) {
+        buffer += '"';
+        for (char character : text) {
+            switch (character) {
+                case '"': buffer += "\\\""; break;
+                case '\\': buffer += "\\\\"; break;
+                case '\n': buffer += "\\n"; break;
+                case '\t': buffer += "\\t"; break;
+                default: {
+                    if (static_cast<unsigned char>(character) < 0x20) {
+                        char escaped[7];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", character);
+                        buffer += escaped;
+                    } else {
+                        buffer += character;
+                    }
+                }
+            }
+        }
+        buffer += '"';
+    }
+
+    const std::string& getFormattedTime(int64_t time) {
+        if (time != cachedSecond or cachedTime.empty()) {
+            auto t = static_cast<std::time_t>(time);
+            std::tm tm {};
+            localtime_r(&t, &tm);
+            char formatted[16];
+            std::strftime(formatted, sizeof(formatted), "%H:%M:%S", &tm);
+            cachedSecond = time;
+            cachedTime = formatted;
+        }
+        return cachedTime;
+    }
+
+    FILE* file;
+    OutputFormat format;
+    std::string buffer;
+    int64_t cachedSecond = 0;
+    std::string cachedTime;
+};
+
+void printUsage() {
+    std::cerr << "Usage: 3PC-trace-merge [--format=text|json] [--output=FILE] TRACE_FILE..." << std::endl;
+}
+
+int main(int argc, char** argv) {
+    OutputFormat format = OutputFormat::TEXT;
+    std::string outputPath;
+    std::vector<std::string> inputPaths;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view argument = argv[i];
+        if (argument == "--format=text") {
+            format = OutputFormat::TEXT;
+        } else if (argument == "--format=json") {
+            format = OutputFormat::JSON;
+        } else if (argument.substr(0, 9) == "--output=") {
+            outputPath = std::string(argument.substr(9));
+        } else if (argument.substr(0, 2) == "--") {
+            printUsage();
+            return 1;
+        } else {
+            inputPaths.emplace_back(argument);
+        }
+    }
+    if (inputPaths.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    try {
+        std::vector<std::unique_ptr<TraceFile>> traces;
+        for (const auto& path : inputPaths) {
+            traces.push_back(std::make_unique<TraceFile>(path));
+        }
+
+        FILE* output = outputPath.empty() ? stdout : std::fopen(outputPath.c_str(), "w");
+        if (output == nullptr) {
+            throw std::runtime_error("Could not open " + outputPath);
+        }
+
+        auto later = [](const TraceFile* first, const TraceFile* second) {
+            const auto& a = first->getHeader();
+            const auto& b = second->getHeader();
+            return std::tie(a.lamportTime, a.rank, a.sequenceNumber) > std::tie(b.lamportTime, b.rank, b.sequenceNumber);
+        };
+        std::priority_queue<TraceFile*, std::vector<TraceFile*>, decltype(later)> queue(later);
+        for (auto& trace : traces) {
+            if (trace->next()) {
+                queue.push(trace.get());
+            }
+        }
+
+        {
+            OutputWriter writer(output, format);
+            while (not queue.empty()) {
+                TraceFile* trace = queue.top();
+                queue.pop();
+                writer.write(*trace);
+                if (trace->next()) {
+                    queue.push(trace);
+                }
+            }
+        }
+
+        if (output != stdout) {
+            std::fclose(output);
+        }
+        for (const auto& trace : traces) {
+            if (trace->getOutOfOrderEntries() > 0) {
+                std::cerr << trace->getPath() << ": " << trace->getOutOfOrderEntries()
+                          << " entries were displaced further than the reorder window and may be slightly misplaced"
+                          << std::endl;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,127 @@
+#ifndef INC_3PC_BUFFERPOOL_H
+#define INC_3PC_BUFFERPOOL_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/** Buffers which grew beyond this capacity are freed instead of being kept in the pool */
+#define POOLED_BUFFER_MAX_CAPACITY (64 * 1024)
+
+class BufferPool;
+
+/**
+ * Byte buffer borrowed from a BufferPool and given back to it on destruction. Move-only.
+ */
+class PooledBuffer {
+public:
+
+    PooledBuffer() = default;
+
+    PooledBuffer(PooledBuffer&& other) noexcept : pool(other.pool), storage(std::move(other.storage)) {
+        other.pool = nullptr;
+    }
+
+    PooledBuffer& operator=(PooledBuffer&& other) noexcept {
+        if (this != &other) {
+            giveBack();
+            pool = other.pool;
+            storage = std::move(other.storage);
+            other.pool = nullptr;
+        }
+        return *this;
+    }
+
+    ~PooledBuffer() {
+        giveBack();
+    }
+
+    char* data() {
+        return storage->data();
+    }
+
+    std::size_t size() const {
+        return storage == nullptr ? 0 : storage->size();
+    }
+
+    /**
+     * @return View of the bytes from the given offset on, valid as long as the buffer is alive (even if moved)
+     */
+    std::string_view view(std::size_t offset = 0) const {
+        return storage == nullptr ? std::string_view() : std::string_view(*storage).substr(offset);
+    }
+
+private:
+    friend class BufferPool;
+
+    PooledBuffer(BufferPool* pool, std::unique_ptr<std::string> storage) : pool(pool), storage(std::move(storage)) { }
+
+    inline void giveBack();
+
+    BufferPool* pool = nullptr;
+    std::unique_ptr<std::string> storage;
+};
+
+/**
+ * Recycles byte buffers, so that once the pool has warmed up, borrowing a buffer no larger than the ones used before
+ * does not allocate. Thread-safe. Has to outlive all the buffers borrowed from it.
+ */
+class BufferPool {
+public:
+
+    /**
+     * @return Buffer of exactly the given size with unspecified contents
+     */
+    PooledBuffer acquire(std::size_t size) {
+        std::unique_ptr<std::string> storage;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (not freeBuffers.empty()) {
+                storage = std::move(freeBuffers.back());
+                freeBuffers.pop_back();
+            }
+        }
+        if (storage == nullptr) {
+            storage = std::make_unique<std::string>();
+        }
+        storage->resize(size);
+        return PooledBuffer(this, std::move(storage));
+    }
+
+    /**
+     * @return Buffer holding a copy of the given bytes, which does not come from the pool if there are none
+     */
+    PooledBuffer copyOf(std::string_view bytes) {
+        if (bytes.empty()) {
+            return PooledBuffer();
+        }
+        PooledBuffer buffer = acquire(bytes.size());
+        bytes.copy(buffer.data(), bytes.size());
+        return buffer;
+    }
+
+private:
+    friend class PooledBuffer;
+
+    void release(std::unique_ptr<std::string> storage) {
+        if (storage->capacity() > POOLED_BUFFER_MAX_CAPACITY) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        freeBuffers.push_back(std::move(storage));
+    }
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<std::string>> freeBuffers;
+};
+
+void PooledBuffer::giveBack() {
+    if (pool != nullptr and storage != nullptr) {
+        pool->release(std::move(storage));
+    }
+    pool = nullptr;
+}
+
+#endif //INC_3PC_BUFFERPOOL_H
@@ -0,0 +1,320 @@
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+#include "Configuration.h"
+#include "StringConcat.h"
+
+Configuration Configuration::instance;
+
+namespace {
+    const std::vector<std::string> keys = {"round-time", "adaptive-timeouts", "min-timeout", "timeout-percentile",
+                                           "failure-detector", "heartbeat-interval", "suspicion-timeout", "termination-protocol", "min-sleep-time", "max-sleep-time", "min-sleep-time-coordinator",
+                                           "max-sleep-time-coordinator", "transactions", "concurrent-transactions",
+                                           "batch-size", "batch-window", "in-order-delivery", "piggyback", "fan-out", "subtree-timeout",
+                                           "participants", "benchmark", "transport", "processes", "wait-strategy", "vote-gathering", "seed", "min-latency",
+                                           "max-latency", "message-cost", "loss", "reordering", "crashes", "logging", "console-log", "trace-prefix",
+                                           "metrics-prefix", "timeline-prefix", "wal-prefix", "group-commit-window",
+                                           "checkpoint-interval", "recover"};
+
+    std::string toEnvironmentName(const std::string& key) {
+        std::string name = "TPC_" + key;
+        std::transform(name.begin(), name.end(), name.begin(), [](char c) { return c == '-' ? '_' : static_cast<char>(std::toupper(c)); });
+        return name;
+    }
+
+    std::string trim(const std::string& text) {
+        auto begin = text.find_first_not_of(" \t\r");
+        if (begin == std::string::npos) {
+            return "";
+        }
+        auto end = text.find_last_not_of(" \t\r");
+        return text.substr(begin, end - begin + 1);
+    }
+
+    long parseLong(const std::string& key, const std::string& value) {
+        try {
+            std::size_t parsedCharacters;
+            long result = std::stol(value, &parsedCharacters);
+            if (parsedCharacters == value.size() and result >= 0) {
+                return result;
+            }
+        } catch (const std::logic_error&) { }
+        throw std::invalid_argument("Value of '" + key + "' must be a non-negative integer, got '" + value + "'");
+    }
+
+    bool parseBool(const std::string& key, const std::string& value) {
+        if (value == "true" or value == "1" or value == "yes") {
+            return true;
+        } else if (value == "false" or value == "0" or value == "no") {
+            return false;
+        }
+        throw std::invalid_argument("Value of '" + key + "' must be true or false, got '" + value + "'");
+    }
+
+    std::vector<ScheduledCrash> parseCrashes(const std::string& key, const std::string& value) {
+        std::vector<ScheduledCrash> crashes;
+        std::size_t begin = 0;
+        while (begin < value.size()) {
+            std::size_t end = std::min(value.find(',', begin), value.size());
+            std::string crash = trim(value.substr(begin, end - begin));
+            auto separator = crash.find('@');
+            if (separator == std::string::npos) {
+                throw std::invalid_argument("Value of '" + key + "' must be a list of 'process@millis', got '" + value + "'");
+            }
+            crashes.push_back({static_cast<ProcessId>(parseLong(key, crash.substr(0, separator))),
+                               parseLong(key, crash.substr(separator + 1))});
+            begin = end + 1;
+        }
+        return crashes;
+    }
+}
+
+void Configuration::load(int argc, char** argv) {
+    Configuration configuration;
+    std::vector<std::pair<std::string, std::string>> arguments;
+    std::string configPath;
+    if (const char* path = std::getenv("TPC_CONFIG")) {
+        configPath = path;
+    }
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument.rfind("--", 0) != 0) {
+            throw std::invalid_argument("Unexpected argument '" + argument + "'");
+        }
+        auto separator = argument.find('=');
+        std::string key = argument.substr(2, separator == std::string::npos ? std::string::npos : separator - 2);
+        std::string value = separator == std::string::npos ? "true" : argument.substr(separator + 1);
+        if (key == "config") {
+            configPath = value;
+        } else {
+            arguments.emplace_back(key, value);
+        }
+    }
+
+    if (not configPath.empty()) {
+        configuration.loadFile(configPath);
+    }
+    configuration.loadEnvironment();
+    for (const auto& [key, value] : arguments) {
+        configuration.set(key, value);
+    }
+
+    if (configuration.benchmark) {
+        configuration.minSleepTime = configuration.maxSleepTime = 0;
+        configuration.minSleepTimeCoordinator = configuration.maxSleepTimeCoordinator = 0;
+        if (not configuration.consoleLogSet) {
+            configuration.consoleLog = false;
+        }
+    }
+    if (configuration.minSleepTime > configuration.maxSleepTime
+        or configuration.minSleepTimeCoordinator > configuration.maxSleepTimeCoordinator) {
+        throw std::invalid_argument("Minimum sleep times must not exceed the maximum ones");
+    }
+    if (configuration.minTimeout > configuration.roundTime) {
+        throw std::invalid_argument("The minimum timeout must not exceed the round time");
+    }
+    if (configuration.heartbeatInterval == 0 or configuration.suspicionTimeout < 2 * configuration.heartbeatInterval) {
+        throw std::invalid_argument("The suspicion timeout must be at least twice the heartbeat interval, which must not be 0");
+    }
+    if (configuration.voteGathering == VoteGathering::COLLECTIVE and configuration.transport != Transport::MPI) {
+        throw std::invalid_argument("Collective vote gathering requires the MPI transport");
+    }
+    if (configuration.recover and configuration.walPrefix.empty()) {
+        throw std::invalid_argument("Recovery needs the write-ahead logs given by 'wal-prefix'");
+    }
+    if (not configuration.walPrefix.empty() and configuration.voteGathering == VoteGathering::COLLECTIVE) {
+        throw std::invalid_argument("The write-ahead log requires point-to-point vote gathering");
+    }
+    if (configuration.batchSize > 1 and (configuration.voteGathering == VoteGathering::COLLECTIVE or not configuration.walPrefix.empty())) {
+        throw std::invalid_argument("Batching requires point-to-point vote gathering and no write-ahead log");
+    }
+    if (configuration.piggyback and configuration.voteGathering == VoteGathering::COLLECTIVE) {
+        throw std::invalid_argument("Piggybacking requires point-to-point vote gathering");
+    }
+    if (configuration.fanOut > 0 and (configuration.voteGathering == VoteGathering::COLLECTIVE or configuration.terminationProtocol)) {
+        throw std::invalid_argument("The tree requires point-to-point vote gathering and no termination protocol");
+    }
+    if (configuration.participants > 0
+        and (configuration.voteGathering == VoteGathering::COLLECTIVE or configuration.fanOut > 0 or configuration.piggyback)) {
+        throw std::invalid_argument("Participant subsets require point-to-point vote gathering in the star and no piggybacking");
+    }
+    if ((configuration.transport == Transport::IN_PROCESS or configuration.transport == Transport::SIMULATED)
+        and configuration.processes < 2) {
+        throw std::invalid_argument("The in-process and simulated transports need a coordinator and at least one cohort member");
+    }
+    if (configuration.minLatency > configuration.maxLatency) {
+        throw std::invalid_argument("The minimum latency must not exceed the maximum one");
+    }
+    for (const auto& crash : configuration.crashes) {
+        if (crash.processId >= configuration.processes) {
+            throw std::invalid_argument(util::concat("Cannot crash the process ", crash.processId, " of ", configuration.processes));
+        }
+    }
+    if (configuration.transport == Transport::SIMULATED and not configuration.seed.has_value()) {
+        // Every random decision of a simulation derives from the seed, so it is fixed here to be reported later
+        configuration.seed = static_cast<unsigned>(std::chrono::system_clock::now().time_since_epoch().count());
+    }
+    if (configuration.concurrentTransactions == 0) {
+        throw std::invalid_argument("At least one transaction has to be allowed in flight");
+    }
+    instance = configuration;
+}
+
+void Configuration::set(const std::string& key, const std::string& value) {
+    if (key == "round-time") {
+        roundTime = parseLong(key, value);
+    } else if (key == "adaptive-timeouts") {
+        adaptiveTimeouts = parseBool(key, value);
+    } else if (key == "min-timeout") {
+        minTimeout = parseLong(key, value);
+    } else if (key == "timeout-percentile") {
+        timeoutPercentile = static_cast<unsigned>(parseLong(key, value));
+        if (timeoutPercentile == 0 or timeoutPercentile > 100) {
+            throw std::invalid_argument("Value of '" + key + "' must be a percentage above 0, got '" + value + "'");
+        }
+    } else if (key == "failure-detector") {
+        failureDetector = parseBool(key, value);
+    } else if (key == "heartbeat-interval") {
+        heartbeatInterval = parseLong(key, value);
+    } else if (key == "suspicion-timeout") {
+        suspicionTimeout = parseLong(key, value);
+    } else if (key == "termination-protocol") {
+        terminationProtocol = parseBool(key, value);
+    } else if (key == "min-sleep-time") {
+        minSleepTime = parseLong(key, value);
+    } else if (key == "max-sleep-time") {
+        maxSleepTime = parseLong(key, value);
+    } else if (key == "min-sleep-time-coordinator") {
+        minSleepTimeCoordinator = parseLong(key, value);
+    } else if (key == "max-sleep-time-coordinator") {
+        maxSleepTimeCoordinator = parseLong(key, value);
+    } else if (key == "transactions") {
+        transactions = static_cast<unsigned>(parseLong(key, value));
+    } else if (key == "concurrent-transactions") {
+        concurrentTransactions = static_cast<unsigned>(parseLong(key, value));
+    } else if (key == "batch-size") {
+        batchSize = static_cast<unsigned>(parseLong(key, value));
+        if (batchSize == 0 or batchSize > MAX_BATCH_SIZE) {
+            throw std::invalid_argument(util::concat("Value of '", key, "' must be between 1 and ", MAX_BATCH_SIZE, ", got '", value, "'"));
+        }
+    } else if (key == "batch-window") {
+        batchWindow = parseLong(key, value);
+    } else if (key == "in-order-delivery") {
+        inOrderDelivery = parseBool(key, value);
+    } else if (key == "piggyback") {
+        piggyback = parseBool(key, value);
+    } else if (key == "fan-out") {
+        fanOut = static_cast<unsigned>(parseLong(key, value));
+    } else if (key == "subtree-timeout") {
+        subtreeTimeout = parseLong(key, value);
+    } else if (key == "participants") {
+        participants = static_cast<unsigned>(parseLong(key, value));
+    } else if (key == "benchmark") {
+        benchmark = parseBool(key, value);
+    } else if (key == "transport") {
+        if (value == "mpi") {
+            transport = Transport::MPI;
+        } else if (value == "shared-memory") {
+            transport = Transport::SHARED_MEMORY;
+        } else if (value == "in-process") {
+            transport = Transport::IN_PROCESS;
+        } else if (value == "simulated") {
+            transport = Transport::SIMULATED;
+        } else {
+            throw std::invalid_argument("Value of '" + key + "' must be mpi, shared-memory, in-process or simulated, got '" + value + "'");
+        }
+    } else if (key == "processes") {
+        processes = static_cast<ProcessId>(parseLong(key, value));
+    } else if (key == "wait-strategy") {
+        if (value == "busy-poll") {
+            waitStrategy = WaitStrategy::BUSY_POLL;
+        } else if (value == "backoff") {
+            waitStrategy = WaitStrategy::BACKOFF;
+        } else {
+            throw std::invalid_argument("Value of '" + key + "' must be busy-poll or backoff, got '" + value + "'");
+        }
+    } else if (key == "vote-gathering") {
+        if (value == "point-to-point") {
+            voteGathering = VoteGathering::POINT_TO_POINT;
+        } else if (value == "collective") {
+            voteGathering = VoteGathering::COLLECTIVE;
+        } else {
+            throw std::invalid_argument("Value of '" + key + "' must be point-to-point or collective, got '" + value + "'");
+        }
+    } else if (key == "seed") {
+        seed = static_cast<unsigned>(parseLong(key, value));
+    } else if (key == "min-latency") {
+        minLatency = parseLong(key, value);
+    } else if (key == "max-latency") {
+        maxLatency = parseLong(key, value);
+    } else if (key == "message-cost") {
+        messageCost = parseLong(key, value);
+    } else if (key == "loss") {
+        lossPercent = static_cast<unsigned>(parseLong(key, value));
+        if (lossPercent > 100) {
+            throw std::invalid_argument("Value of '" + key + "' must be a percentage, got '" + value + "'");
+        }
+    } else if (key == "reordering") {
+        reordering = parseBool(key, value);
+    } else if (key == "crashes") {
+        crashes = parseCrashes(key, value);
+    } else if (key == "logging") {
+        if (value == "sync") {
+            logging = LoggingMode::SYNCHRONOUS;
+        } else if (value == "async") {
+            logging = LoggingMode::ASYNCHRONOUS;
+        } else {
+            throw std::invalid_argument("Value of '" + key + "' must be sync or async, got '" + value + "'");
+        }
+    } else if (key == "console-log") {
+        consoleLog = parseBool(key, value);
+        consoleLogSet = true;
+    } else if (key == "trace-prefix") {
+        tracePrefix = value;
+    } else if (key == "metrics-prefix") {
+        metricsPrefix = value;
+    } else if (key == "wal-prefix") {
+        walPrefix = value;
+    } else if (key == "group-commit-window") {
+        groupCommitWindow = parseLong(key, value);
+    } else if (key == "checkpoint-interval") {
+        checkpointInterval = parseLong(key, value);
+    } else if (key == "recover") {
+        recover = parseBool(key, value);
+    } else if (key == "timeline-prefix") {
+        timelinePrefix = value;
+    } else {
+        throw std::invalid_argument("Unknown configuration key '" + key + "'");
+    }
+}
+
+void Configuration::loadFile(const std::string& path) {
+    std::ifstream file(path);
+    if (not file) {
+        throw std::invalid_argument("Could not open the configuration file " + path);
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+        auto separator = line.find('=');
+        if (separator == std::string::npos) {
+            throw std::invalid_argument("Expected 'key = value' in " + path + ", got '" + line + "'");
+        }
+        set(trim(line.substr(0, separator)), trim(line.substr(separator + 1)));
+    }
+}
+
+void Configuration::loadEnvironment() {
+    for (const auto& key : keys) {
+        if (const char* value = std::getenv(toEnvironmentName(key).c_str())) {
+            set(key, value);
+        }
+    }
+}
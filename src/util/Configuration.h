@@ -0,0 +1,143 @@
+#ifndef INC_3PC_CONFIGURATION_H
+#define INC_3PC_CONFIGURATION_H
+
+#include <optional>
+#include <string>
+#include <vector>
+#include <communication/Backoff.h>
+#include <communication/ICollectiveVoting.h>
+#include <logging/Logger.h>
+
+/**
+ * Medium the processes communicate through.
+ */
+enum class Transport : unsigned char {
+    MPI,
+    /** Shared memory segment, only for processes running on a single host */
+    SHARED_MEMORY,
+    /** Every participant is a thread of a single process, no launcher needed */
+    IN_PROCESS,
+    /** Like IN_PROCESS, but on a simulated network in virtual time */
+    SIMULATED
+};
+
+/**
+ * Crash signal the simulated network delivers to a process at the given virtual time.
+ */
+struct ScheduledCrash {
+    ProcessId processId;
+    long timeMillis;
+};
+
+/**
+ * Runtime settings of the program. Each setting has a key, e.g. 'round-time', and is read from the following sources,
+ * later ones overriding earlier ones:
+ *  - compile-time defaults from Define.h,
+ *  - a configuration file given by the 'config' key, containing 'key = value' lines ('#' starts a comment),
+ *  - environment variables named after the keys, e.g. TPC_ROUND_TIME,
+ *  - command line arguments, e.g. --round-time=500 (a boolean key alone, e.g. --benchmark, means true).
+ */
+class Configuration {
+public:
+    /** Maximum time in milliseconds to wait for the messages of a single protocol phase */
+    long roundTime = ROUND_TIME;
+    /** Whether phase timeouts are derived from the observed round-trip times, with the round time as their ceiling */
+    bool adaptiveTimeouts = false;
+    /** Floor of the adaptive timeouts in milliseconds */
+    long minTimeout = MIN_TIMEOUT;
+    /** Percentage of the recent round-trip times an adaptive timeout covers, before the jitter margin is added */
+    unsigned timeoutPercentile = TIMEOUT_PERCENTILE;
+    /** Whether the processes exchange heartbeats to detect crashed peers before the phase timeouts expire */
+    bool failureDetector = false;
+    /** Time in milliseconds between the heartbeats of a process which sends nothing else */
+    long heartbeatInterval = HEARTBEAT_INTERVAL;
+    /** Time in milliseconds without any message from a peer after which it is suspected to have crashed */
+    long suspicionTimeout = SUSPICION_TIMEOUT;
+    /** Whether the cohort members agree on the outcome among themselves when they give up on the coordinator */
+    bool terminationProtocol = false;
+    /** Bounds of the artificial pause in milliseconds a cohort member makes between protocol steps */
+    long minSleepTime = MIN_SLEEP_TIME;
+    long maxSleepTime = MAX_SLEEP_TIME;
+    /** Bounds of the artificial pause in milliseconds the coordinator makes between protocol steps */
+    long minSleepTimeCoordinator = MIN_SLEEP_TIME_COORDINATOR;
+    long maxSleepTimeCoordinator = MAX_SLEEP_TIME_COORDINATOR;
+    /** Number of 3PC instances the coordinator runs */
+    unsigned transactions = TRANSACTION_COUNT;
+    /** Maximum number of transactions in flight at the same time, batched or not */
+    unsigned concurrentTransactions = CONCURRENT_TRANSACTIONS;
+    /** Maximum number of transactions the coordinator decides in a single 3PC instance */
+    unsigned batchSize = BATCH_SIZE;
+    /** Maximum time in microseconds a transaction waits for the rest of its batch */
+    long batchWindow = BATCH_WINDOW;
+    /** Whether the coordinator hands decisions over in the order the transactions arrived, rather than as they are reached */
+    bool inOrderDelivery = false;
+    /** Whether protocol messages of different transactions for the same recipients share a wire message */
+    bool piggyback = false;
+    /** Children of every rank in the tree the protocol messages travel along, 0 for a star around the coordinator */
+    unsigned fanOut = FAN_OUT;
+    /** Time in milliseconds a relay of the tree waits for the responses of its subtree, per level below it */
+    long subtreeTimeout = SUBTREE_TIMEOUT;
+    /** Cohort members every transaction touches, 0 for the whole cohort */
+    unsigned participants = PARTICIPANTS;
+    /** Removes the artificial pauses, disables console logging by default and prints performance figures at exit */
+    bool benchmark = false;
+    Transport transport = Transport::MPI;
+    /** Number of participants, coordinator included, of the in-process and simulated transports (otherwise given by the launcher) */
+    ProcessId processes = IN_PROCESS_PROCESSES;
+    /** How threads wait for incoming messages */
+    WaitStrategy waitStrategy = WaitStrategy::BACKOFF;
+    /** How requests reach the cohort and responses reach the coordinator */
+    VoteGathering voteGathering = VoteGathering::POINT_TO_POINT;
+    /** Seed of the random decisions of the processes (and of the simulated network), taken from the time if not set */
+    std::optional<unsigned> seed;
+    /** Bounds of the latency in milliseconds of a message on the simulated network */
+    long minLatency = SIMULATED_MIN_LATENCY;
+    long maxLatency = SIMULATED_MAX_LATENCY;
+    /** Time in microseconds a process of the simulated network spends on every message it sends or receives */
+    long messageCost = 0;
+    /** Percentage of the messages between different processes the simulated network loses */
+    unsigned lossPercent = 0;
+    /** Whether the simulated network may deliver the messages of a sender to a recipient out of order */
+    bool reordering = true;
+    /** Crash signals of the simulation, given as 'process@millis' separated by commas */
+    std::vector<ScheduledCrash> crashes;
+    LoggingMode logging = LoggingMode::ASYNCHRONOUS;
+    /** Whether log entries are printed to the standard output */
+    bool consoleLog = true;
+    /** If not empty, every process writes a binary trace to <tracePrefix>.<rank>.bin */
+    std::string tracePrefix;
+    /** If not empty, every process writes its metrics to <metricsPrefix>.<rank>.metrics at exit */
+    std::string metricsPrefix;
+    /** If not empty, every process logs its state transitions durably to <walPrefix>.<rank>.wal */
+    std::string walPrefix;
+    /** Maximum time in microseconds a logged state transition waits for more transitions to share its flush */
+    long groupCommitWindow = GROUP_COMMIT_WINDOW;
+    /** Number of log records after which the write-ahead log is truncated by a checkpoint, 0 for never */
+    long checkpointInterval = CHECKPOINT_INTERVAL;
+    /** Whether the processes resume from their existing write-ahead logs instead of replacing them */
+    bool recover = false;
+    /** If not empty, every process writes a Chrome trace of its protocol activity to <timelinePrefix>.<rank>.json at exit */
+    std::string timelinePrefix;
+
+    /**
+     * Builds the configuration from all the sources. Throws std::invalid_argument on unknown keys or malformed values.
+     * Does not need MPI to be initialized, see main.
+     */
+    static void load(int argc, char** argv);
+
+    static const Configuration& get() {
+        return instance;
+    }
+
+private:
+    void set(const std::string& key, const std::string& value);
+    void loadFile(const std::string& path);
+    void loadEnvironment();
+
+    /** Whether console logging was configured explicitly, in which case benchmark mode does not change it */
+    bool consoleLogSet = false;
+
+    static Configuration instance;
+};
+
+#endif //INC_3PC_CONFIGURATION_H
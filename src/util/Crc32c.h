@@ -0,0 +1,37 @@
+#ifndef INC_3PC_CRC32C_H
+#define INC_3PC_CRC32C_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace crc32cDetail {
+    constexpr std::array<uint32_t, 256> makeTable() {
+        std::array<uint32_t, 256> table {};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                // Reversed Castagnoli polynomial
+                crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78u : 0);
+            }
+            table[i] = crc;
+        }
+        return table;
+    }
+
+    constexpr std::array<uint32_t, 256> table = makeTable();
+}
+
+/**
+ * CRC-32C (Castagnoli) of the given bytes, computed a byte at a time from a lookup table.
+ */
+inline uint32_t crc32c(const void* data, std::size_t size) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    uint32_t crc = 0xFFFFFFFFu;
+    for (std::size_t i = 0; i < size; ++i) {
+        crc = crc32cDetail::table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+#endif //INC_3PC_CRC32C_H
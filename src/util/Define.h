@@ -2,15 +2,42 @@
 #define INC_3PC_DEFINE_H
 
 #include <map>
+#include <string>
+#include <ostream>
 
 #define LOGGER_NUMBER_DIGITS 7
+#define LOGGER_RING_CAPACITY 1024
+#define LOG_RECORD_MESSAGE_SIZE 160
 #define ROUND_TIME 10000
+#define MIN_TIMEOUT 50
+#define TIMEOUT_PERCENTILE 99
+#define RTT_WINDOW 32
+#define RTT_MIN_SAMPLES 8
+#define HEARTBEAT_INTERVAL 100
+#define SUSPICION_TIMEOUT 500
+#define GROUP_COMMIT_WINDOW 1000
+#define CHECKPOINT_INTERVAL 10000
+#define DECISION_HISTORY 4096
 #define MIN_SLEEP_TIME 6000
 #define MAX_SLEEP_TIME 7000
 #define MIN_SLEEP_TIME_COORDINATOR 4000
 #define MAX_SLEEP_TIME_COORDINATOR 5000
 #define COORDINATOR_ID 0
+#define TRANSACTION_COUNT 1
+#define CONCURRENT_TRANSACTIONS 1
+#define BATCH_SIZE 1
+#define MAX_BATCH_SIZE 64
+#define BATCH_WINDOW 1000
+#define BUNDLE_CAPACITY 1024
+#define FAN_OUT 0
+#define SUBTREE_TIMEOUT 2000
+#define PARTICIPANTS 0
+#define IN_PROCESS_PROCESSES 3
+#define SIMULATED_MIN_LATENCY 1
+#define SIMULATED_MAX_LATENCY 10
 #define MPI_CRASH_TAG 100
+#define MPI_HEARTBEAT_TAG 101
+#define MAX_BACKOFF_MICROS 1000
 
 enum State : unsigned char {
     Q, W, A, P ,C
@@ -40,7 +67,7 @@ namespace std {
 }
 
 enum class MessageType : unsigned char {
-    CAN_COMMIT, PREPARE_COMMIT, DO_COMMIT, DO_ABORT, COMMIT_AGREE, COMMIT_ACK, CRASH
+    CAN_COMMIT, PREPARE_COMMIT, DO_COMMIT, DO_ABORT, COMMIT_AGREE, COMMIT_ACK, CRASH, HEARTBEAT, STATE_REQUEST, STATE_REPORT, BUNDLE
 };
 
 const std::map<MessageType, std::string>  messageTypeString = {{MessageType::CAN_COMMIT, "CAN_COMMIT"},
@@ -49,7 +76,11 @@ const std::map<MessageType, std::string>  messageTypeString = {{MessageType::CAN
                                                                {MessageType::DO_ABORT, "DO_ABORT"},
                                                                {MessageType::COMMIT_AGREE, "COMMIT_AGREE"},
                                                                {MessageType::COMMIT_ACK, "COMMIT_ACK"},
-                                                               {MessageType::CRASH, "CRASH"}};
+                                                               {MessageType::CRASH, "CRASH"},
+                                                               {MessageType::HEARTBEAT, "HEARTBEAT"},
+                                                               {MessageType::STATE_REQUEST, "STATE_REQUEST"},
+                                                               {MessageType::STATE_REPORT, "STATE_REPORT"},
+                                                               {MessageType::BUNDLE, "BUNDLE"}};
 
 inline std::ostream& operator<< (std::ostream& os, MessageType messageType) {
     return os << messageTypeString.at(messageType);
@@ -0,0 +1,123 @@
+#ifndef INC_3PC_HISTOGRAM_H
+#define INC_3PC_HISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "StringConcat.h"
+
+/** Every power of two is split into 2^HISTOGRAM_SUB_BUCKET_BITS buckets, which bounds the relative error to about 6% */
+#define HISTOGRAM_SUB_BUCKET_BITS 4
+
+/**
+ * Latency histogram with log-linear buckets in the spirit of HdrHistogram, covering every non-negative 64-bit value
+ * with a fixed relative precision. Recording is a single relaxed atomic increment, so any number of threads can record
+ * without locks. Histograms have the same buckets everywhere, so those of different processes can be merged by adding
+ * up their counts.
+ */
+class Histogram {
+public:
+
+    static constexpr std::size_t SUB_BUCKETS = std::size_t(1) << HISTOGRAM_SUB_BUCKET_BITS;
+    static constexpr std::size_t BUCKETS = (64 - HISTOGRAM_SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    void record(uint64_t value) {
+        counts[getBucket(value)].fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    void record(std::chrono::steady_clock::duration latency) {
+        record(static_cast<uint64_t>(std::max<std::chrono::nanoseconds::rep>(
+                0, std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count())));
+    }
+
+    /**
+     * Adds the given number of values of a bucket, e.g. when merging histograms.
+     */
+    void add(std::size_t bucket, uint64_t count) {
+        counts.at(bucket).fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void addToSum(uint64_t value) {
+        sum.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    uint64_t getCount(std::size_t bucket) const {
+        return counts[bucket].load(std::memory_order_relaxed);
+    }
+
+    uint64_t getTotalCount() const {
+        uint64_t total = 0;
+        for (const auto& count : counts) {
+            total += count.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    uint64_t getSum() const {
+        return sum.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @return Upper bound of the bucket containing the value at the given fraction of the recorded values, 0 if empty
+     */
+    uint64_t getPercentile(double fraction) const {
+        const uint64_t total = getTotalCount();
+        if (total == 0) {
+            return 0;
+        }
+        const auto rank = static_cast<uint64_t>(fraction * static_cast<double>(total - 1)) + 1;
+        uint64_t seen = 0;
+        for (std::size_t bucket = 0; bucket < BUCKETS; ++bucket) {
+            seen += getCount(bucket);
+            if (seen >= rank) {
+                return getUpperBound(bucket);
+            }
+        }
+        return getUpperBound(BUCKETS - 1);
+    }
+
+    /**
+     * @return Count, mean, median, 99th percentile and maximum of the recorded nanoseconds in microseconds
+     */
+    std::string summary() const {
+        const uint64_t total = getTotalCount();
+        if (total == 0) {
+            return "no samples";
+        }
+        return util::concat(total, " samples, mean ", toMicros(static_cast<double>(getSum()) / total), " us, p50 ",
+                            toMicros(getPercentile(0.5)), " us, p99 ", toMicros(getPercentile(0.99)), " us, max ",
+                            toMicros(getPercentile(1.0)), " us");
+    }
+
+    static std::size_t getBucket(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<std::size_t>(value);
+        }
+        const unsigned shift = 63 - __builtin_clzll(value) - HISTOGRAM_SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKETS + static_cast<std::size_t>((value >> shift) - SUB_BUCKETS);
+    }
+
+    static uint64_t getUpperBound(std::size_t bucket) {
+        if (bucket < SUB_BUCKETS) {
+            return bucket;
+        }
+        const std::size_t shift = bucket / SUB_BUCKETS - 1;
+        const uint64_t lowerBound = (SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+        return lowerBound + ((uint64_t(1) << shift) - 1);
+    }
+
+private:
+
+    static double toMicros(double nanoseconds) {
+        return static_cast<double>(static_cast<uint64_t>(nanoseconds / 100.0 + 0.5)) / 10.0;
+    }
+
+    std::array<std::atomic<uint64_t>, BUCKETS> counts {};
+    std::atomic<uint64_t> sum {0};
+};
+
+#endif //INC_3PC_HISTOGRAM_H
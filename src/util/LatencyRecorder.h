@@ -0,0 +1,53 @@
+#ifndef INC_3PC_LATENCYRECORDER_H
+#define INC_3PC_LATENCYRECORDER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include <string>
+#include <vector>
+#include "StringConcat.h"
+
+/**
+ * Collects latency samples and summarizes them. Meant for benchmark reports, not for the protocol's hot path.
+ */
+class LatencyRecorder {
+public:
+
+    void record(std::chrono::steady_clock::duration latency) {
+        samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count());
+    }
+
+    std::size_t count() const {
+        return samples.size();
+    }
+
+    /**
+     * @return Mean, median, 99th percentile and maximum of the samples in microseconds
+     */
+    std::string summary() {
+        if (samples.empty()) {
+            return "no samples";
+        }
+        std::sort(samples.begin(), samples.end());
+        double mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+        return util::concat("mean ", toMicros(mean), " us, p50 ", toMicros(percentile(0.5)), " us, p99 ",
+                            toMicros(percentile(0.99)), " us, max ", toMicros(samples.back()), " us");
+    }
+
+private:
+
+    double percentile(double fraction) const {
+        auto index = static_cast<std::size_t>(fraction * (samples.size() - 1));
+        return samples[index];
+    }
+
+    static double toMicros(double nanoseconds) {
+        return std::round(nanoseconds / 100.0) / 10.0;
+    }
+
+    std::vector<long> samples;
+};
+
+#endif //INC_3PC_LATENCYRECORDER_H
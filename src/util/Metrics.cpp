@@ -0,0 +1,111 @@
+#include <sstream>
+#include <stdexcept>
+#include "Metrics.h"
+
+void MetricsDump::addHistogram(const std::string& name, const Histogram& histogram) {
+    Histogram& target = histograms[name];
+    for (std::size_t bucket = 0; bucket < Histogram::BUCKETS; ++bucket) {
+        uint64_t count = histogram.getCount(bucket);
+        if (count > 0) {
+            target.add(bucket, count);
+        }
+    }
+    target.addToSum(histogram.getSum());
+}
+
+void MetricsDump::write(std::ostream& output) const {
+    output << "3PC-metrics " << METRICS_FORMAT_VERSION << '\n';
+    for (const auto& [name, value] : counters) {
+        output << "counter " << name << ' ' << value << '\n';
+    }
+    for (const auto& [name, histogram] : histograms) {
+        output << "histogram " << name << ' ' << histogram.getSum();
+        for (std::size_t bucket = 0; bucket < Histogram::BUCKETS; ++bucket) {
+            uint64_t count = histogram.getCount(bucket);
+            if (count > 0) {
+                output << ' ' << bucket << ':' << count;
+            }
+        }
+        output << '\n';
+    }
+}
+
+void MetricsDump::read(std::istream& input) {
+    std::string line;
+    if (not std::getline(input, line) or line != util::concat("3PC-metrics ", METRICS_FORMAT_VERSION)) {
+        throw std::runtime_error("Not a metrics dump of a supported version");
+    }
+    while (std::getline(input, line)) {
+        std::istringstream fields(line);
+        std::string kind, name;
+        uint64_t value;
+        if (not (fields >> kind >> name >> value)) {
+            throw std::runtime_error("Malformed metrics line '" + line + "'");
+        }
+        if (kind == "counter") {
+            counters[name] += value;
+        } else if (kind == "histogram") {
+            Histogram& histogram = histograms[name];
+            histogram.addToSum(value);
+            std::string bucketCount;
+            while (fields >> bucketCount) {
+                auto separator = bucketCount.find(':');
+                if (separator == std::string::npos) {
+                    throw std::runtime_error("Malformed histogram bucket '" + bucketCount + "'");
+                }
+                histogram.add(std::stoul(bucketCount.substr(0, separator)), std::stoull(bucketCount.substr(separator + 1)));
+            }
+        } else {
+            throw std::runtime_error("Unknown metrics line '" + line + "'");
+        }
+    }
+}
+
+void MetricsDump::print(std::ostream& output) const {
+    for (const auto& [name, value] : counters) {
+        output << name << ": " << value << '\n';
+    }
+    for (const auto& [name, histogram] : histograms) {
+        output << name << ": " << histogram.summary() << '\n';
+    }
+}
+
+void ProtocolMetrics::dump(MetricsDump& metricsDump, const CommunicationCounters& communicationCounters) const {
+    metricsDump.addCounter("transactions.committed", committed.load(std::memory_order_relaxed));
+    metricsDump.addCounter("transactions.aborted", aborted.load(std::memory_order_relaxed));
+    metricsDump.addCounter("timeouts", timeouts.load(std::memory_order_relaxed));
+    metricsDump.addCounter("suspicions", suspicions.load(std::memory_order_relaxed));
+    metricsDump.addCounter("terminations", terminations.load(std::memory_order_relaxed));
+    metricsDump.addCounter("unexpected-packets", unexpectedPackets.load(std::memory_order_relaxed));
+    metricsDump.addCounter("piggybacked-messages", piggybackedMessages.load(std::memory_order_relaxed));
+    metricsDump.addCounter("log.records", loggedRecords.load(std::memory_order_relaxed));
+    metricsDump.addCounter("log.syncs", logSyncs.load(std::memory_order_relaxed));
+    metricsDump.addCounter("messages.sent", communicationCounters.messagesSent.load(std::memory_order_relaxed));
+    metricsDump.addCounter("bytes.sent", communicationCounters.bytesSent.load(std::memory_order_relaxed));
+    metricsDump.addCounter("messages.received", communicationCounters.messagesReceived.load(std::memory_order_relaxed));
+    metricsDump.addCounter("bytes.received", communicationCounters.bytesReceived.load(std::memory_order_relaxed));
+    metricsDump.addCounter("messages.dropped", communicationCounters.messagesDropped.load(std::memory_order_relaxed));
+    // Only the histograms with samples are written, which keeps states and messages a process never sees out of the dump
+    for (const auto& [state, name] : stateString) {
+        const Histogram& duration = stateDurations[static_cast<std::size_t>(state)];
+        if (duration.getTotalCount() > 0) {
+            metricsDump.addHistogram("state." + name, duration);
+        }
+        const Histogram& gather = gatherDurations[static_cast<std::size_t>(state)];
+        if (gather.getTotalCount() > 0) {
+            metricsDump.addHistogram("gather." + name, gather);
+        }
+    }
+    if (logSyncDurations.getTotalCount() > 0) {
+        metricsDump.addHistogram("log.sync", logSyncDurations);
+    }
+    if (terminationDurations.getTotalCount() > 0) {
+        metricsDump.addHistogram("termination", terminationDurations);
+    }
+    for (const auto& [messageType, name] : messageTypeString) {
+        const Histogram& wait = messageWaits[static_cast<std::size_t>(messageType)];
+        if (wait.getTotalCount() > 0) {
+            metricsDump.addHistogram("wait." + name, wait);
+        }
+    }
+}
@@ -0,0 +1,148 @@
+#ifndef INC_3PC_METRICS_H
+#define INC_3PC_METRICS_H
+
+#include <atomic>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+#include "Define.h"
+#include "Histogram.h"
+
+#define METRICS_FORMAT_VERSION 1
+
+/**
+ * Traffic of one communicator. Updated with relaxed atomic increments, so that it can stay enabled everywhere.
+ */
+struct CommunicationCounters {
+    std::atomic<uint64_t> messagesSent {0};
+    /** Bytes of the sent messages as handed to the transport, i.e. encoded if the transport encodes them */
+    std::atomic<uint64_t> bytesSent {0};
+    std::atomic<uint64_t> messagesReceived {0};
+    std::atomic<uint64_t> bytesReceived {0};
+    /** Messages the transport gave up on, e.g. as their recipient is gone */
+    std::atomic<uint64_t> messagesDropped {0};
+
+    void recordSent(uint64_t messages, uint64_t bytesPerMessage) {
+        messagesSent.fetch_add(messages, std::memory_order_relaxed);
+        bytesSent.fetch_add(messages * bytesPerMessage, std::memory_order_relaxed);
+    }
+
+    void recordReceived(uint64_t bytes) {
+        messagesReceived.fetch_add(1, std::memory_order_relaxed);
+        bytesReceived.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void recordDropped() {
+        messagesDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * Named counters and histograms in a text form which can be written to a file and read back, adding up the values of
+ * several files. Every process writes one at exit, the metrics merge tool aggregates them.
+ */
+class MetricsDump {
+public:
+
+    void addCounter(const std::string& name, uint64_t value) {
+        counters[name] += value;
+    }
+
+    /**
+     * Adds the counts of the given histogram to the one of the given name.
+     */
+    void addHistogram(const std::string& name, const Histogram& histogram);
+
+    /**
+     * Writes one line per counter and histogram, histograms listing their non-empty buckets only.
+     */
+    void write(std::ostream& output) const;
+
+    /**
+     * Adds the values written by write() to this dump. Throws std::runtime_error on malformed input.
+     */
+    void read(std::istream& input);
+
+    /**
+     * Writes the counters and a summary of every histogram in a human-readable form.
+     */
+    void print(std::ostream& output) const;
+
+private:
+    std::map<std::string, uint64_t> counters;
+    std::map<std::string, Histogram> histograms;
+};
+
+/**
+ * Instrumentation of the 3PC state machine of one process. Lock-free, every recording is a few relaxed atomic
+ * increments.
+ */
+class ProtocolMetrics {
+public:
+
+    /**
+     * @return Times transactions spent in the given state, from entering it until leaving it
+     */
+    Histogram& stateDuration(State state) {
+        return stateDurations[static_cast<std::size_t>(state)];
+    }
+
+    /**
+     * @return Times from entering a state until a packet of the given type arrived for the transaction
+     */
+    Histogram& messageWait(MessageType messageType) {
+        return messageWaits[static_cast<std::size_t>(messageType)];
+    }
+
+    /**
+     * @return Times the coordinator waited in the given state for the response of the slowest cohort member
+     */
+    Histogram& gatherDuration(State state) {
+        return gatherDurations[static_cast<std::size_t>(state)];
+    }
+
+    /**
+     * @return Times the write-ahead log took to write and flush a group of records
+     */
+    Histogram& logSyncDuration() {
+        return logSyncDurations;
+    }
+
+    /**
+     * @return Times from giving up on the coordinator until the termination protocol decided the transaction
+     */
+    Histogram& terminationDuration() {
+        return terminationDurations;
+    }
+
+    std::atomic<uint64_t> committed {0};
+    std::atomic<uint64_t> aborted {0};
+    std::atomic<uint64_t> timeouts {0};
+    /** Transactions given up because the failure detector suspected a peer they were waiting for */
+    std::atomic<uint64_t> suspicions {0};
+    /** Transactions decided by the termination protocol after this process gave up on the coordinator */
+    std::atomic<uint64_t> terminations {0};
+    std::atomic<uint64_t> unexpectedPackets {0};
+    /** Protocol messages sent in a bundle together with messages of other transactions */
+    std::atomic<uint64_t> piggybackedMessages {0};
+    std::atomic<uint64_t> loggedRecords {0};
+    std::atomic<uint64_t> logSyncs {0};
+
+    /**
+     * Adds these metrics and the given communication counters to the dump.
+     */
+    void dump(MetricsDump& metricsDump, const CommunicationCounters& communicationCounters) const;
+
+private:
+    static constexpr std::size_t STATE_COUNT = 5;
+    static constexpr std::size_t MESSAGE_TYPE_COUNT = 11;
+
+    Histogram stateDurations[STATE_COUNT];
+    Histogram messageWaits[MESSAGE_TYPE_COUNT];
+    Histogram gatherDurations[STATE_COUNT];
+    Histogram logSyncDurations;
+    Histogram terminationDurations;
+};
+
+#endif //INC_3PC_METRICS_H
@@ -0,0 +1,150 @@
+#ifndef INC_3PC_RANKSET_H
+#define INC_3PC_RANKSET_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <vector>
+
+/**
+ * Set of process ranks as a bitset with a bit per rank, up to the highest rank inserted so far. Inserting and looking
+ * a rank up are a bit operation each, the size is kept up to date on the way, and iterating skips whole words of
+ * absent ranks. Clearing keeps the storage, so a set reused for every phase of a transaction allocates once at most.
+ */
+class RankSet {
+public:
+
+    /**
+     * Visits the ranks in ascending order.
+     */
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = int;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const int*;
+        using reference = int;
+
+        Iterator(const std::vector<uint64_t>& words, std::size_t index) : words(&words), index(index) {
+            skipEmptyWords();
+        }
+
+        int operator*() const {
+            return static_cast<int>(index * WORD_BITS + static_cast<std::size_t>(__builtin_ctzll(bits)));
+        }
+
+        Iterator& operator++() {
+            // Clears the lowest set bit
+            bits &= bits - 1;
+            if (bits == 0) {
+                ++index;
+                skipEmptyWords();
+            }
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return index == other.index and bits == other.bits;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return not (*this == other);
+        }
+
+    private:
+        void skipEmptyWords() {
+            while (index < words->size() and (*words)[index] == 0) {
+                ++index;
+            }
+            bits = index < words->size() ? (*words)[index] : 0;
+        }
+
+        const std::vector<uint64_t>* words;
+        std::size_t index;
+        /** Ranks of the current word which are still to be visited */
+        uint64_t bits = 0;
+    };
+
+    RankSet() = default;
+
+    RankSet(std::initializer_list<int> ranks) : RankSet(ranks.begin(), ranks.end()) { }
+
+    template <typename InputIterator>
+    RankSet(InputIterator first, InputIterator last) {
+        for (; first != last; ++first) {
+            insert(*first);
+        }
+    }
+
+    /**
+     * @param rank Not negative
+     * @return Whether the rank was not in the set yet
+     */
+    bool insert(int rank) {
+        const auto index = static_cast<std::size_t>(rank) / WORD_BITS;
+        if (index >= words.size()) {
+            words.resize(index + 1, 0);
+        }
+        const uint64_t bit = uint64_t(1) << (static_cast<std::size_t>(rank) % WORD_BITS);
+        if (words[index] & bit) {
+            return false;
+        }
+        words[index] |= bit;
+        ++elements;
+        return true;
+    }
+
+    /**
+     * @return Whether the rank was in the set
+     */
+    bool erase(int rank) {
+        if (not contains(rank)) {
+            return false;
+        }
+        words[static_cast<std::size_t>(rank) / WORD_BITS] &= ~(uint64_t(1) << (static_cast<std::size_t>(rank) % WORD_BITS));
+        --elements;
+        return true;
+    }
+
+    bool contains(int rank) const {
+        const auto index = static_cast<std::size_t>(rank) / WORD_BITS;
+        return rank >= 0 and index < words.size() and (words[index] >> (static_cast<std::size_t>(rank) % WORD_BITS)) & 1;
+    }
+
+    std::size_t size() const {
+        return elements;
+    }
+
+    bool empty() const {
+        return elements == 0;
+    }
+
+    void clear() {
+        std::fill(words.begin(), words.end(), 0);
+        elements = 0;
+    }
+
+    Iterator begin() const {
+        return Iterator(words, 0);
+    }
+
+    Iterator end() const {
+        return Iterator(words, words.size());
+    }
+
+private:
+    static constexpr std::size_t WORD_BITS = 64;
+
+    std::vector<uint64_t> words;
+    std::size_t elements = 0;
+};
+
+#endif //INC_3PC_RANKSET_H
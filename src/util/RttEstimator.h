@@ -0,0 +1,88 @@
+#ifndef INC_3PC_RTTESTIMATOR_H
+#define INC_3PC_RTTESTIMATOR_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <optional>
+#include <vector>
+#include "Define.h"
+
+/**
+ * Per-peer round-trip time statistics, from which the timeouts of the protocol phases are derived. Every peer keeps
+ * a window of its latest samples and the mean deviation of its samples (the RTTVAR of RFC 6298). The timeout for
+ * a peer is the given percentile of its window plus four mean deviations, bounded by the given floor and ceiling.
+ * Until a peer has RTT_MIN_SAMPLES samples, its timeout is the ceiling.
+ *
+ * Not thread-safe, every process has to use it from its main thread only.
+ */
+class RttEstimator {
+public:
+    using Duration = std::chrono::steady_clock::duration;
+
+    /**
+     * @param percentile Percentage of the samples in the window the timeout has to cover
+     */
+    RttEstimator(std::size_t numberOfPeers, Duration floor, Duration ceiling, unsigned percentile)
+        : peers(numberOfPeers), floor(floor), ceiling(ceiling), percentile(percentile) { }
+
+    void record(std::size_t peer, Duration rtt) {
+        Peer& state = peers.at(peer);
+        if (state.samples == 0) {
+            state.smoothed = rtt;
+            state.deviation = rtt / 2;
+        } else {
+            // RFC 6298 with alpha = 1/8 and beta = 1/4
+            const Duration error = rtt > state.smoothed ? rtt - state.smoothed : state.smoothed - rtt;
+            state.deviation = (3 * state.deviation + error) / 4;
+            state.smoothed = (7 * state.smoothed + rtt) / 8;
+        }
+        state.window[state.samples % RTT_WINDOW] = rtt;
+        ++state.samples;
+        state.timeout = computeTimeout(state);
+    }
+
+    Duration getPeerTimeout(std::size_t peer) const {
+        return peers.at(peer).timeout.value_or(ceiling);
+    }
+
+    /**
+     * @return Timeout long enough for the slowest of the given peers. Not cached, as a relay of the tree asks for its
+     * parent and for its children, and the loop costs little next to the messages sent to the same peers.
+     */
+    template <typename Peers>
+    Duration getTimeout(const Peers& peerIds) const {
+        Duration timeout = floor;
+        for (auto peer : peerIds) {
+            timeout = std::max(timeout, getPeerTimeout(static_cast<std::size_t>(peer)));
+        }
+        return timeout;
+    }
+
+private:
+    struct Peer {
+        std::array<Duration, RTT_WINDOW> window {};
+        unsigned long samples = 0;
+        Duration smoothed {};
+        Duration deviation {};
+        std::optional<Duration> timeout;
+    };
+
+    std::optional<Duration> computeTimeout(const Peer& state) const {
+        if (state.samples < RTT_MIN_SAMPLES) {
+            return std::nullopt;
+        }
+        const auto size = static_cast<std::size_t>(std::min<unsigned long>(state.samples, RTT_WINDOW));
+        std::array<Duration, RTT_WINDOW> sorted = state.window;
+        auto nth = sorted.begin() + static_cast<std::ptrdiff_t>((size - 1) * percentile / 100);
+        std::nth_element(sorted.begin(), nth, sorted.begin() + static_cast<std::ptrdiff_t>(size));
+        return std::clamp(*nth + 4 * state.deviation, floor, ceiling);
+    }
+
+    std::vector<Peer> peers;
+    Duration floor;
+    Duration ceiling;
+    unsigned percentile;
+};
+
+#endif //INC_3PC_RTTESTIMATOR_H
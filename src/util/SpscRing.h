@@ -0,0 +1,85 @@
+#ifndef INC_3PC_SPSCRING_H
+#define INC_3PC_SPSCRING_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+#define CACHE_LINE_SIZE 64
+
+/**
+ * Bounded lock-free queue for exactly one producer thread and one consumer thread.
+ * @tparam T Element type, copied in and out of the ring
+ * @tparam Capacity Maximum number of elements, has to be a power of two
+ */
+template <typename T, std::size_t Capacity>
+class SpscRing {
+    static_assert(Capacity > 0 and (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+
+    /**
+     * Constructs an element in place. May only be called by the producer.
+     * @param fill Callable initializing the element passed to it by reference
+     * @return Whether there was free space in the ring
+     */
+    template <typename Fill>
+    bool tryPush(Fill fill) {
+        const std::size_t currentTail = tail.load(std::memory_order_relaxed);
+        if (currentTail - cachedHead == Capacity) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (currentTail - cachedHead == Capacity) {
+                return false;
+            }
+        }
+        fill(items[currentTail & (Capacity - 1)]);
+        tail.store(currentTail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Passes every element currently in the ring to the consumer function and removes them. May only be called
+     * by the consumer.
+     * @return Number of consumed elements
+     */
+    template <typename Consume>
+    std::size_t drain(Consume consume) {
+        const std::size_t currentHead = head.load(std::memory_order_relaxed);
+        const std::size_t currentTail = tail.load(std::memory_order_acquire);
+        for (std::size_t position = currentHead; position != currentTail; ++position) {
+            consume(items[position & (Capacity - 1)]);
+        }
+        head.store(currentTail, std::memory_order_release);
+        return currentTail - currentHead;
+    }
+
+    /**
+     * Passes the oldest element to the consumer function and removes it. May only be called by the consumer.
+     * @return Whether there was an element in the ring
+     */
+    template <typename Consume>
+    bool tryPop(Consume consume) {
+        const std::size_t currentHead = head.load(std::memory_order_relaxed);
+        if (currentHead == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        consume(items[currentHead & (Capacity - 1)]);
+        head.store(currentHead + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    /** Read position, written by the consumer only */
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> head {0};
+    /** Write position, written by the producer only */
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> tail {0};
+    /** Producer's last observed read position, saves touching the consumer's cache line on every push */
+    std::size_t cachedHead = 0;
+    alignas(CACHE_LINE_SIZE) std::array<T, Capacity> items;
+};
+
+#endif //INC_3PC_SPSCRING_H
@@ -0,0 +1,98 @@
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <communication/MpiOptimizedCommunicator.h>
+
+/**
+ * Counts the heap allocations of vote rounds once the buffer pools have warmed up: the coordinator sends CAN_COMMIT to
+ * the cohort and receives COMMIT_AGREE from every member. MPI allocates with malloc, so only the allocations of the
+ * communicator itself are counted, of which there must be none.
+ *
+ * Usage: mpirun -np 3 3PC-test-allocations simple|optimized
+ */
+
+namespace {
+    const unsigned WARM_UP_ROUNDS = 100;
+    const unsigned COUNTED_ROUNDS = 1000;
+
+    std::atomic<bool> counting = false;
+    std::atomic<unsigned long> allocations = 0;
+
+    void* allocate(std::size_t size) {
+        if (counting.load(std::memory_order_relaxed)) {
+            allocations.fetch_add(1, std::memory_order_relaxed);
+        }
+        void* memory = std::malloc(size == 0 ? 1 : size);
+        if (memory == nullptr) {
+            throw std::bad_alloc();
+        }
+        return memory;
+    }
+
+    void round(ICommunicator& communicator, TransactionId transactionId) {
+        if (communicator.getProcessId() == COORDINATOR_ID) {
+            communicator.sendOthers(transactionId, MessageType::CAN_COMMIT, "");
+            for (ProcessId response = 1; response < communicator.getNumberOfProcesses(); ++response) {
+                communicator.receive();
+            }
+        } else {
+            Packet request = communicator.receive();
+            communicator.send(request.transactionId, MessageType::COMMIT_AGREE, "", COORDINATOR_ID);
+        }
+    }
+}
+
+void* operator new(std::size_t size) {
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return allocate(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2 or (std::strcmp(argv[1], "simple") != 0 and std::strcmp(argv[1], "optimized") != 0)) {
+        std::cerr << "Usage: mpirun -np 3 3PC-test-allocations simple|optimized" << std::endl;
+        return 1;
+    }
+    // Made shared like in Main, so that the destructor of the created type finalizes MPI
+    std::shared_ptr<ICommunicator> communicator;
+    if (std::strcmp(argv[1], "simple") == 0) {
+        communicator = std::make_shared<MpiSimpleCommunicator>(argc, argv);
+    } else {
+        communicator = std::make_shared<MpiOptimizedCommunicator>(argc, argv);
+    }
+    TransactionId transactionId = 0;
+    for (unsigned i = 0; i < WARM_UP_ROUNDS; ++i) {
+        round(*communicator, transactionId++);
+    }
+    counting = true;
+    for (unsigned i = 0; i < COUNTED_ROUNDS; ++i) {
+        round(*communicator, transactionId++);
+    }
+    counting = false;
+    const unsigned long counted = allocations.load();
+    std::cout << "Process " << communicator->getProcessId() << ": " << counted << " allocations in " << COUNTED_ROUNDS
+              << " rounds with the " << argv[1] << " communicator" << std::endl;
+    return counted == 0 ? 0 : 1;
+}
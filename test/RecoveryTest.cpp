@@ -0,0 +1,105 @@
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+#include <storage/WriteAheadLog.h>
+#include <util/StringConcat.h>
+
+/**
+ * Restarts a simulated cluster of 4 processes from write-ahead logs prepared to look like a crash in the middle of
+ * the transaction 0, and checks that every process decides it the same way, and where the outcome is determined,
+ * that it is the expected one.
+ *
+ * Usage: 3PC-test-recovery PATH_TO_3PC
+ */
+
+namespace {
+    const ProcessId PROCESSES = 4;
+
+    struct Scenario {
+        std::string name;
+        /** States the transaction 0 went through at every rank before the crash */
+        std::vector<std::vector<State>> logged;
+        /** The outcome the cohort has to agree on, or none if either one is safe */
+        std::optional<State> expected;
+        std::string options;
+    };
+
+    std::string walPath(const std::string& prefix, ProcessId rank) {
+        return util::concat(prefix, ".", rank, ".wal");
+    }
+
+    /**
+     * @return Whether every process decided the transaction 0 as expected
+     */
+    bool run(const std::string& executable, const std::string& directory, const Scenario& scenario) {
+        const std::string prefix = directory + "/" + scenario.name;
+        for (ProcessId rank = 0; rank < PROCESSES; ++rank) {
+            WriteAheadLog log(walPath(prefix, rank), rank, false, 0);
+            for (State state : scenario.logged[static_cast<std::size_t>(rank)]) {
+                log.append(0, state);
+            }
+            log.sync();
+        }
+        const std::string command = util::concat(executable, " --transport=simulated --processes=", PROCESSES,
+                                                 " --transactions=4 --benchmark --console-log=false --recover --wal-prefix=",
+                                                 prefix, " ", scenario.options, " > /dev/null");
+        if (std::system(command.c_str()) != 0) {
+            std::cerr << scenario.name << ": failed to run " << command << std::endl;
+            return false;
+        }
+        std::map<ProcessId, State> decisions;
+        for (ProcessId rank = 0; rank < PROCESSES; ++rank) {
+            WriteAheadLog log(walPath(prefix, rank), rank, true, 0);
+            const auto& recovery = log.getRecovery();
+            auto decision = recovery.decided.find(0);
+            if (recovery.inFlight.count(0) > 0 or decision == recovery.decided.end()) {
+                std::cerr << scenario.name << ": the process " << rank << " did not decide the transaction 0" << std::endl;
+                return false;
+            }
+            decisions[rank] = decision->second;
+        }
+        const State outcome = scenario.expected.value_or(decisions[COORDINATOR_ID]);
+        bool agreed = true;
+        for (const auto& [rank, decision] : decisions) {
+            if (decision != outcome) {
+                std::cerr << scenario.name << ": the process " << rank << " decided " << decision << " instead of " << outcome << std::endl;
+                agreed = false;
+            }
+        }
+        return agreed;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "Usage: 3PC-test-recovery PATH_TO_3PC" << std::endl;
+        return 1;
+    }
+    char directoryTemplate[] = "/tmp/3PC-test-recovery-XXXXXX";
+    if (mkdtemp(directoryTemplate) == nullptr) {
+        std::cerr << "Could not create a temporary directory" << std::endl;
+        return 1;
+    }
+    const std::vector<Scenario> scenarios = {
+            // The coordinator logged P and crashed before its PREPARE_COMMIT went out, so the cohort may abort on its own
+            {"unsent-prepare", {{W, P}, {W}, {W}, {W}}, A, ""},
+            {"unsent-prepare-terminating", {{W, P}, {W}, {W}, {W}}, A, "--termination-protocol=true"},
+            {"prepared", {{W, P}, {W, P}, {W, P}, {W, P}}, C, ""},
+            {"committed-member", {{W, P}, {W, P, C}, {W, P}, {W, P}}, C, "--termination-protocol=true"},
+            // The PREPARE_COMMIT reached part of the cohort only, either outcome is fine as long as everybody agrees
+            {"partly-prepared-terminating", {{W, P}, {W, P}, {W}, {W}}, std::nullopt, "--termination-protocol=true"},
+    };
+    int failures = 0;
+    for (const auto& scenario : scenarios) {
+        if (run(argv[1], directoryTemplate, scenario)) {
+            std::cout << scenario.name << ": passed" << std::endl;
+        } else {
+            ++failures;
+        }
+    }
+    std::system(util::concat("rm -rf ", directoryTemplate).c_str());
+    return failures == 0 ? 0 : 1;
+}